@@ -44,18 +44,13 @@ endif ()
 option(BUILD_PLUGIN_GSTREAMER "Include GStreamer Plugin" ON)
 if (BUILD_PLUGIN_GSTREAMER)
     ENABLE_PLUGIN(gstreamer)
-    pkg_check_modules(GST REQUIRED gstreamer-1.0>=1.4)
-    pkg_check_modules(GST_VIDEO REQUIRED gstreamer-video-1.0>=1.4)
-    pkg_check_modules(AVFORMAT libavformat<59.16.100)
-    if (AVFORMAT_FOUND)
-        message(STATUS "AVFORMAT without Const FOUND")
-    else ()
-        pkg_check_modules(AVFORMAT REQUIRED libavformat>=59.16.100)
-        message(STATUS "AVFORMAT with Const FOUND")
-        add_definitions(-DAVFORMAT_WITH_CONST)
-    endif ()
+    pkg_check_modules(GST REQUIRED gstreamer-1.0>=1.10)
+    pkg_check_modules(GST_VIDEO REQUIRED gstreamer-video-1.0>=1.10)
+    pkg_check_modules(GST_APP REQUIRED gstreamer-app-1.0>=1.10)
 endif ()
 
+option(BUILD_GSTREAMER_BENCHMARK "Build headless GStreamer frame path benchmark" OFF)
+
 option(BUILD_PLUGIN_TEXT_INPUT "Includes Text Input Plugin" ON)
 if (BUILD_PLUGIN_TEXT_INPUT)
     ENABLE_PLUGIN(text_input)
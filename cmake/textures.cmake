@@ -18,6 +18,11 @@ include(macros)
 
 set(TEXTURES)
 
+option(BUILD_TEXTURE_PIXEL_BUFFER "Includes CPU Pixel Buffer Texture" OFF)
+if (BUILD_TEXTURE_PIXEL_BUFFER)
+    ENABLE_TEXTURE(pixel_buffer)
+endif ()
+
 option(BUILD_TEXTURE_TEST "Includes Test Texture" OFF)
 if (BUILD_TEXTURE_TEST)
     ENABLE_TEXTURE(test)
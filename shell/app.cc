@@ -14,8 +14,11 @@
 
 #include "app.h"
 
+#include <poll.h>
+
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <flutter/fml/logging.h>
 
@@ -47,10 +50,6 @@ App::App(const std::string& app_id,
                                                sprawl,
                                                width,
                                                height)}
-#ifdef ENABLE_TEXTURE_TEST
-      ,
-      m_texture_test(std::make_unique<TextureTest>(this))
-#endif
 #ifdef ENABLE_PLUGIN_TEXT_INPUT
       ,
       m_text_input(std::make_shared<TextInput>())
@@ -78,6 +77,14 @@ App::App(const std::string& app_id,
       exit(-1);
     }
 
+    // Texture memory budget
+    const char* envstr_budget;
+    if ((envstr_budget = getenv("TEXTURE_MEMORY_BUDGET_MB")) != nullptr) {
+      auto val = strtoul(envstr_budget, nullptr, 10);
+      FML_LOG(INFO) << "(" << i << ") Texture Memory Budget: " << val << "MB";
+      m_engine[i]->SetTextureMemoryBudget(val * 1024 * 1024);
+    }
+
     // Set Flutter Window Size
     auto result = m_engine[i]->SetWindowSize(m_egl_window[i]->GetHeight(),
                                              m_egl_window[i]->GetWidth());
@@ -92,7 +99,10 @@ App::App(const std::string& app_id,
   m_display->SetEngine(m_engine[0]);
 
 #ifdef ENABLE_TEXTURE_TEST
-  m_texture_test->SetEngine(m_engine[0]);
+  for (size_t i = 0; i < TextureTest::GetConfig().count; i++) {
+    m_texture_test.emplace_back(std::make_unique<TextureTest>(this, i));
+    m_texture_test.back()->SetEngine(m_engine[0]);
+  }
 #endif
 #ifdef ENABLE_PLUGIN_TEXT_INPUT
   m_text_input->SetEngine(m_engine[0]);
@@ -157,17 +167,53 @@ int App::Loop() {
   }
 
 #ifdef ENABLE_TEXTURE_TEST
-  if (m_texture_test) {
-    m_texture_test->Draw(m_texture_test.get());
+  for (auto& texture_test : m_texture_test) {
+    texture_test->Draw(texture_test.get());
   }
 #endif
 
+  // one frame available notification per dirty texture per loop iteration
+  for (auto& i : m_engine) {
+    i->FlushTextureFrames();
+  }
+
   while (wl_display_prepare_read(m_display->GetDisplay()) != 0) {
     wl_display_dispatch_pending(m_display->GetDisplay());
   }
   wl_display_flush(m_display->GetDisplay());
 
-  wl_display_read_events(m_display->GetDisplay());
+  // Frame callbacks stop once nothing commits, so texture producers wake
+  // the loop through their engine's eventfd.
+  std::vector<pollfd> fds;
+  fds.push_back({wl_display_get_fd(m_display->GetDisplay()), POLLIN, 0});
+  for (auto& i : m_engine) {
+    if (i && i->GetTextureFrameFd() >= 0) {
+      fds.push_back({i->GetTextureFrameFd(), POLLIN, 0});
+    }
+  }
+  int timeout = -1;
+#ifdef ENABLE_TEXTURE_TEST
+  // timed test uploads run from this loop, wake up for the next one
+  for (auto& texture_test : m_texture_test) {
+    int64_t next = texture_test->GetNextFrameTime();
+    if (next == 0) {
+      continue;
+    }
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+    int wait_ms =
+        next > now ? static_cast<int>((next - now + 999999) / 1000000) : 0;
+    if (timeout < 0 || wait_ms < timeout) {
+      timeout = wait_ms;
+    }
+  }
+#endif
+  if (poll(fds.data(), fds.size(), timeout) > 0 && fds[0].revents) {
+    wl_display_read_events(m_display->GetDisplay());
+  } else {
+    wl_display_cancel_read(m_display->GetDisplay());
+  }
   auto ret = wl_display_dispatch_pending(m_display->GetDisplay());
 
   auto end_time = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -20,6 +20,7 @@
 #include <flutter_embedder.h>
 #include <wayland-client.h>
 #include <memory>
+#include <vector>
 
 #include "constants.h"
 #ifdef ENABLE_TEXTURE_TEST
@@ -45,7 +46,7 @@ class App {
   uint32_t m_fps_counter;
   int32_t m_fps_pretime;
 #ifdef ENABLE_TEXTURE_TEST
-  std::unique_ptr<TextureTest> m_texture_test;
+  std::vector<std::unique_ptr<TextureTest>> m_texture_test;
 #endif
 #ifdef ENABLE_PLUGIN_TEXT_INPUT
   std::shared_ptr<TextInput> m_text_input;
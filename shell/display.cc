@@ -231,7 +231,7 @@ void Display::display_handle_mode(void* data,
                                   [[maybe_unused]] uint32_t flags,
                                   int width,
                                   int height,
-                                  [[maybe_unused]] int refresh) {
+                                  int refresh) {
   auto* d = static_cast<Display*>(data);
 
   if (wl_output == d->m_output && (flags & WL_OUTPUT_MODE_CURRENT)) {
@@ -242,10 +242,12 @@ void Display::display_handle_mode(void* data,
     d->m_info.mode.width = width;
     d->m_info.mode.height = height;
     d->m_info.mode.dots_per_in = dots_per_in;
+    d->m_info.mode.refresh = refresh;
 
     FML_DLOG(INFO) << "width: " << d->m_info.mode.width;
     FML_DLOG(INFO) << "height: " << d->m_info.mode.height;
     FML_DLOG(INFO) << "dpi: " << d->m_info.mode.dots_per_in;
+    FML_DLOG(INFO) << "refresh: " << d->m_info.mode.refresh;
   }
 }
 
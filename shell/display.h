@@ -74,6 +74,10 @@ class Display {
   [[maybe_unused]] [[nodiscard]] int32_t GetModeHeight() const {
     return m_info.mode.height;
   }
+  // refresh rate of the current mode in mHz, 0 if not reported
+  [[nodiscard]] int32_t GetModeRefresh() const {
+    return m_info.mode.refresh;
+  }
 
   [[maybe_unused]] void AglShellDoBackground(struct wl_surface*);
   [[maybe_unused]] void AglShellDoPanel(struct wl_surface*,
@@ -195,6 +199,7 @@ class Display {
       int32_t width;
       int32_t height;
       double dots_per_in;
+      int32_t refresh;
     } mode{};
 
     struct {
@@ -696,3 +696,42 @@ bool Egl::MakeTextureCurrent() {
   }
   return false;
 }
+
+EGLContext Egl::CreateProducerContext() {
+  EGLContext context = eglCreateContext(m_dpy, m_config, m_context[0],
+                                        kEglContextAttribs.data());
+  if (context == EGL_NO_CONTEXT) {
+    FML_LOG(ERROR) << "CreateProducerContext failed: " << eglGetError();
+    return EGL_NO_CONTEXT;
+  }
+  FML_DLOG(INFO) << "producer context = " << context;
+  return context;
+}
+
+bool Egl::MakeProducerCurrent(EGLContext context) {
+  if (context == EGL_NO_CONTEXT) {
+    FML_LOG(ERROR) << "MakeProducerCurrent: no producer context";
+    return false;
+  }
+  if (eglGetCurrentContext() == context) {
+    return true;
+  }
+  eglMakeCurrent(m_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+  EGLint egl_error = eglGetError();
+  if (egl_error != EGL_SUCCESS) {
+    FML_LOG(ERROR) << "MakeProducerCurrent failed: " << egl_error;
+    return false;
+  }
+  return true;
+}
+
+void Egl::DestroyProducerContext(EGLContext context) {
+  if (context == EGL_NO_CONTEXT) {
+    return;
+  }
+  if (eglGetCurrentContext() == context) {
+    ClearCurrent();
+  }
+  // deletion is deferred by EGL while still current on a producer thread
+  eglDestroyContext(m_dpy, context);
+}
@@ -44,6 +44,14 @@ class Egl {
   bool MakeResourceCurrent(size_t index);
   bool MakeTextureCurrent();
 
+  // Producer contexts share objects with the engine context.  A producer
+  // creates one for its lifetime and leaves it bound to its thread, so
+  // frames can be uploaded without a global lock or per-frame
+  // eglMakeCurrent calls.
+  EGLContext CreateProducerContext();
+  bool MakeProducerCurrent(EGLContext context);
+  void DestroyProducerContext(EGLContext context);
+
  protected:
   EGLSurface m_egl_surface[kEngineInstanceCount]{};
   EGLDisplay m_dpy;
@@ -20,6 +20,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <utility>
 
@@ -445,10 +446,22 @@ void EglWindow::redraw(void* data,
   window->m_callback = wl_surface_frame(window->m_surface);
   wl_callback_add_listener(window->m_callback, &frame_listener, window);
 
+  // the callback time has an undefined base, so the arrival is used
+  window->m_frame_time =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+
   window->m_fps_counter++;
   window->m_fps_counter++;
 }
 
+int64_t EglWindow::GetFrameInterval() const {
+  int32_t refresh = m_display->GetModeRefresh();
+  // 60 Hz until the output reports its mode
+  return refresh > 0 ? 1000000000000LL / refresh : 16666667;
+}
+
 uint32_t EglWindow::GetFpsCounter() {
   uint32_t fps_counter = m_fps_counter;
   m_fps_counter = 0;
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -57,6 +58,11 @@ class EglWindow : public Egl {
   uint32_t GetFpsCounter();
   void DrawFps(uint8_t fps);
 
+  // CLOCK_MONOTONIC time (ns) of the last surface frame callback, 0 before
+  // the first one.  Display frames follow it at GetFrameInterval().
+  [[nodiscard]] int64_t GetLastFrameTime() const { return m_frame_time; }
+  [[nodiscard]] int64_t GetFrameInterval() const;
+
   bool ActivateSystemCursor(int32_t device, const std::string& kind);
 
   uint32_t m_fps_counter;
@@ -91,6 +97,7 @@ class EglWindow : public Egl {
 
   struct shm_buffer m_buffers[2]{};
   struct wl_callback* m_callback;
+  std::atomic<int64_t> m_frame_time{};
   bool m_configured;
 
   int m_frame_sync;
@@ -12,12 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <chrono>
 #include <vector>
 
 #include <dlfcn.h>
 #include <linux/input-event-codes.h>
 #include <pwd.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -57,6 +59,13 @@ Engine::Engine(App* app,
       m_gl_resolver(app->GetGlResolver()),
       m_flutter_engine(nullptr),
       m_platform_channel(PlatformChannel::GetInstance()),
+      m_texture_memory_total(0),
+      m_texture_memory_peak(0),
+      m_texture_memory_budget(0),
+      m_texture_memory_exceeded_count(0),
+      m_texture_memory_pressure(false),
+      m_texture_memory_over(false),
+      m_texture_frame_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
       m_cache_path(std::move(GetPersistentCachePath())),
       m_args({
           .struct_size = sizeof(FlutterProjectArgs),
@@ -126,14 +135,19 @@ Engine::Engine(App* app,
                       size_t height,
                       FlutterOpenGLTexture* texture_out) -> bool {
                  auto e = reinterpret_cast<Engine*>(userdata);
-                 auto texture = e->m_texture_registry[texture_id];
-                 if (texture) {
-                   texture->GetFlutterOpenGLTexture(texture_out,
-                                                    static_cast<int>(width),
-                                                    static_cast<int>(height));
-                   return true;
+                 std::shared_lock<std::shared_mutex> lock(
+                     e->m_texture_registry_mutex);
+                 auto search = e->m_texture_registry.find(texture_id);
+                 // deferred textures have no GL texture yet
+                 if (search == e->m_texture_registry.end() ||
+                     search->second == nullptr ||
+                     search->second->GetTextureId() == 0) {
+                   return false;
                  }
-                 return false;
+                 search->second->GetFlutterOpenGLTexture(
+                     texture_out, static_cast<int>(width),
+                     static_cast<int>(height));
+                 return true;
                },
            }}) {
   FML_DLOG(INFO) << "(" << m_index << ") +Engine::Engine";
@@ -246,6 +260,9 @@ Engine::~Engine() {
     }
     dlclose(m_engine_so_handle);
   }
+  if (m_texture_frame_fd >= 0) {
+    close(m_texture_frame_fd);
+  }
 }
 
 FlutterEngineResult Engine::RunTask() {
@@ -350,6 +367,7 @@ FlutterEngineResult Engine::SetWindowSize(size_t height, size_t width) {
 
 FlutterEngineResult Engine::TextureRegistryAdd(int64_t texture_id,
                                                Texture* texture) {
+  std::unique_lock<std::shared_mutex> lock(m_texture_registry_mutex);
   this->m_texture_registry[texture_id] = texture;
   FML_DLOG(INFO) << "Added Texture (" << texture_id << ") to registry";
   return kSuccess;
@@ -357,6 +375,7 @@ FlutterEngineResult Engine::TextureRegistryAdd(int64_t texture_id,
 
 [[maybe_unused]] FlutterEngineResult Engine::TextureRegistryRemove(
     int64_t texture_id) {
+  std::unique_lock<std::shared_mutex> lock(m_texture_registry_mutex);
   auto search =
       std::find_if(m_texture_registry.begin(), m_texture_registry.end(),
                    [&texture_id](const std::pair<int64_t, void*>& element) {
@@ -375,6 +394,17 @@ FlutterEngineResult Engine::TextureRegistryAdd(int64_t texture_id,
   return kInvalidArguments;
 }
 
+void Engine::TextureRegistryRemove(Texture* texture) {
+  std::unique_lock<std::shared_mutex> lock(m_texture_registry_mutex);
+  for (auto it = m_texture_registry.begin(); it != m_texture_registry.end();) {
+    if (it->second == texture) {
+      it = m_texture_registry.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 FlutterEngineResult Engine::TextureEnable(int64_t texture_id) {
   FML_DLOG(INFO) << "Enable Texture ID: " << texture_id;
   return m_proc_table.RegisterExternalTexture(m_flutter_engine, texture_id);
@@ -382,6 +412,10 @@ FlutterEngineResult Engine::TextureEnable(int64_t texture_id) {
 
 FlutterEngineResult Engine::TextureDisable(int64_t texture_id) {
   FML_DLOG(INFO) << "Disable Texture ID: " << texture_id;
+  {
+    std::lock_guard<std::mutex> lock(m_texture_frame_mutex);
+    m_texture_frames_pending.erase(texture_id);
+  }
   return m_proc_table.UnregisterExternalTexture(m_flutter_engine, texture_id);
 }
 
@@ -392,12 +426,45 @@ FlutterEngineResult Engine::MarkExternalTextureFrameAvailable(
       engine->m_flutter_engine, texture_id);
 }
 
+void Engine::QueueTextureFrameAvailable(int64_t texture_id) {
+  std::lock_guard<std::mutex> lock(m_texture_frame_mutex);
+  bool wake = m_texture_frames_pending.empty();
+  m_texture_frames_pending.insert(texture_id);
+  if (wake && m_texture_frame_fd >= 0) {
+    uint64_t one = 1;
+    if (write(m_texture_frame_fd, &one, sizeof(one)) < 0) {
+      FML_DLOG(ERROR) << "texture frame wakeup failed";
+    }
+  }
+}
+
+void Engine::FlushTextureFrames() {
+  std::set<int64_t> pending;
+  {
+    std::lock_guard<std::mutex> lock(m_texture_frame_mutex);
+    if (m_texture_frames_pending.empty()) {
+      return;
+    }
+    pending.swap(m_texture_frames_pending);
+    uint64_t count;
+    if (m_texture_frame_fd >= 0) {
+      // nonblocking, only resets the counter
+      (void)read(m_texture_frame_fd, &count, sizeof(count));
+    }
+  }
+  for (auto texture_id : pending) {
+    m_proc_table.MarkExternalTextureFrameAvailable(m_flutter_engine,
+                                                   texture_id);
+  }
+}
+
 int64_t Engine::TextureCreate(int64_t texture_id,
                               int32_t width,
                               int32_t height) {
   FML_DLOG(INFO) << "Engine::TextureCreate: <" << texture_id << ">";
 
-  auto texture = this->m_texture_registry[texture_id];
+  // the create callback registers the texture under its GL name
+  auto texture = GetTextureObj(texture_id);
 
   if (texture != nullptr) {
     int64_t id = texture->Create(width, height);
@@ -429,19 +496,106 @@ std::string Engine::GetPersistentCachePath() {
 FlutterEngineResult Engine::TextureDispose(int64_t texture_id) {
   FML_DLOG(INFO) << "OpenGL Texture: dispose (" << texture_id << ")";
 
-  auto search =
-      std::find_if(m_texture_registry.begin(), m_texture_registry.end(),
-                   [&texture_id](const std::pair<int64_t, void*>& element) {
-                     return element.first == texture_id;
-                   });
-  if (search != m_texture_registry.end()) {
-    ((Texture*)search->second)->Dispose();
+  auto texture = GetTextureObj(texture_id);
+  if (texture != nullptr) {
+    texture->Dispose();
     FML_DLOG(INFO) << "Texture Disposed (" << texture_id << ")";
     return kSuccess;
   }
   return kInvalidArguments;
 }
 
+void Engine::TextureMemoryAdd(size_t bytes) {
+  size_t total = m_texture_memory_total += bytes;
+
+  size_t peak = m_texture_memory_peak;
+  while (total > peak &&
+         !m_texture_memory_peak.compare_exchange_weak(peak, total)) {
+  }
+
+  size_t budget = m_texture_memory_budget;
+  if (budget && total > budget) {
+    m_texture_memory_exceeded_count++;
+    FML_LOG(INFO) << "Texture memory over budget: " << total << " > "
+                  << budget;
+    NotifyTextureMemoryPressure();
+  }
+}
+
+void Engine::TextureMemoryRemove(size_t bytes) {
+  size_t total = m_texture_memory_total;
+  size_t update;
+  do {
+    update = (bytes > total) ? 0 : total - bytes;
+  } while (!m_texture_memory_total.compare_exchange_weak(total, update));
+
+  // tell producers that backed off that the pressure is over
+  size_t budget = m_texture_memory_budget;
+  if (m_texture_memory_over && (!budget || update <= budget)) {
+    NotifyTextureMemoryPressure();
+  }
+}
+
+// Tells producers how far the total is over budget, or 0 once it is back
+// under budget, so they can scale their response or undo it.
+void Engine::NotifyTextureMemoryPressure() {
+  // producers releasing memory from within the callback must not re-enter
+  if (m_texture_memory_pressure.exchange(true)) {
+    return;
+  }
+  size_t total = m_texture_memory_total;
+  size_t budget = m_texture_memory_budget;
+  size_t over_budget = (budget && total > budget) ? total - budget : 0;
+  m_texture_memory_over = over_budget > 0;
+
+  // textures are registered under both object id and GL name.  Callbacks
+  // run under the registry lock and must not add or remove textures.
+  std::shared_lock<std::shared_mutex> lock(m_texture_registry_mutex);
+  std::vector<Texture*> notified;
+  for (auto const& item : m_texture_registry) {
+    auto texture = item.second;
+    // every texture learns that the pressure ended, not only those that
+    // still hold memory
+    if (texture == nullptr || (over_budget && !texture->GetMemoryUsage()) ||
+        std::find(notified.begin(), notified.end(), texture) !=
+            notified.end()) {
+      continue;
+    }
+    notified.push_back(texture);
+    texture->OnMemoryPressure(over_budget);
+  }
+  lock.unlock();
+
+  m_texture_memory_pressure = false;
+  // releases made from the callbacks may have ended the pressure
+  total = m_texture_memory_total;
+  if (over_budget && total <= budget) {
+    NotifyTextureMemoryPressure();
+  }
+}
+
+TextureMemoryStats Engine::GetTextureMemoryStats() {
+  TextureMemoryStats stats{
+      .total_bytes = m_texture_memory_total,
+      .peak_bytes = m_texture_memory_peak,
+      .budget_bytes = m_texture_memory_budget,
+      .budget_exceeded_count = m_texture_memory_exceeded_count,
+  };
+  std::shared_lock<std::shared_mutex> lock(m_texture_registry_mutex);
+  std::vector<Texture*> visited;
+  for (auto const& item : m_texture_registry) {
+    auto texture = item.second;
+    if (texture == nullptr ||
+        std::find(visited.begin(), visited.end(), texture) != visited.end()) {
+      continue;
+    }
+    visited.push_back(texture);
+    stats.textures.emplace_back(texture->GetTextureId(),
+                                texture->GetMemoryUsage());
+  }
+  return stats;
+}
+
 FlutterEngineResult Engine::SendPlatformMessageResponse(
     const FlutterPlatformMessageResponseHandle* handle,
     const uint8_t* data,
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 
 #include <EGL/egl.h>
@@ -25,6 +27,8 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <set>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -41,6 +45,14 @@ class Texture;
 class TextInput;
 #endif
 
+struct TextureMemoryStats {
+  size_t total_bytes;
+  size_t peak_bytes;
+  size_t budget_bytes;
+  size_t budget_exceeded_count;
+  std::vector<std::pair<int64_t, size_t>> textures;
+};
+
 class Engine {
  public:
   Engine(App* app,
@@ -65,6 +77,8 @@ class Engine {
   FlutterEngineResult TextureRegistryAdd(int64_t texture_id, Texture* texture);
   [[maybe_unused]] [[maybe_unused]] FlutterEngineResult TextureRegistryRemove(
       int64_t texture_id);
+  // drops every id |texture| is registered under
+  void TextureRegistryRemove(Texture* texture);
 
   FlutterEngineResult TextureEnable(int64_t texture_id);
   FlutterEngineResult TextureDisable(int64_t texture_id);
@@ -72,10 +86,32 @@ class Engine {
       const std::shared_ptr<Engine>& engine,
       int64_t texture_id);
 
+  // Coalesced frame notification.  Producers queue from any thread, the
+  // platform loop flushes once per frame.  The eventfd is readable while
+  // frames are pending, so the loop wakes up without a Wayland event.
+  void QueueTextureFrameAvailable(int64_t texture_id);
+  void FlushTextureFrames();
+  [[nodiscard]] int GetTextureFrameFd() const { return m_texture_frame_fd; }
+
   int64_t TextureCreate(int64_t texture_id, int32_t width, int32_t height);
 
   FlutterEngineResult TextureDispose(int64_t texture_id);
 
+  void TextureMemoryAdd(size_t bytes);
+  void TextureMemoryRemove(size_t bytes);
+  // 0 disables budget enforcement
+  void SetTextureMemoryBudget(size_t bytes) { m_texture_memory_budget = bytes; }
+  // bytes producers may still allocate, SIZE_MAX without a budget
+  [[nodiscard]] size_t GetTextureMemoryHeadroom() const {
+    size_t budget = m_texture_memory_budget;
+    size_t total = m_texture_memory_total;
+    if (!budget) {
+      return SIZE_MAX;
+    }
+    return total < budget ? budget - total : 0;
+  }
+  TextureMemoryStats GetTextureMemoryStats();
+
   static std::string GetPersistentCachePath();
 
   FlutterEngineResult SendPlatformMessageResponse(
@@ -108,7 +144,9 @@ class Engine {
                       int32_t device);
 
   [[maybe_unused]] Texture* GetTextureObj(int64_t texture_id) {
-    return m_texture_registry[texture_id];
+    std::shared_lock<std::shared_mutex> lock(m_texture_registry_mutex);
+    auto search = m_texture_registry.find(texture_id);
+    return search == m_texture_registry.end() ? nullptr : search->second;
   }
 
   [[maybe_unused]] std::shared_ptr<GlResolver> GetGlResolver() {
@@ -140,8 +178,25 @@ class Engine {
   std::string m_cache_path;
 
   PlatformChannel* m_platform_channel;
+  // written on the platform thread, read by the raster thread and by
+  // producers reporting allocations
+  std::shared_mutex m_texture_registry_mutex;
   std::map<int64_t, Texture*> m_texture_registry;
 
+  std::atomic<size_t> m_texture_memory_total;
+  std::atomic<size_t> m_texture_memory_peak;
+  std::atomic<size_t> m_texture_memory_budget;
+  std::atomic<size_t> m_texture_memory_exceeded_count;
+  std::atomic<bool> m_texture_memory_pressure;
+  // producers were last told the total is over budget
+  std::atomic<bool> m_texture_memory_over;
+
+  void NotifyTextureMemoryPressure();
+
+  std::mutex m_texture_frame_mutex;
+  int m_texture_frame_fd;
+  std::set<int64_t> m_texture_frames_pending;
+
   FlutterEngine m_flutter_engine;
   FlutterProjectArgs m_args;
   FlutterRendererConfig m_renderer_config{};
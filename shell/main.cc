@@ -133,6 +133,86 @@ int main(int argc, char** argv) {
         args.erase(result);
       }
     }
+#ifdef ENABLE_TEXTURE_TEST
+    TextureTest::Config texture_test_config;
+    if (cl.HasOption("texture-test-count")) {
+      std::string count_str;
+      cl.GetOptionValue("texture-test-count", &count_str);
+      if (count_str.empty()) {
+        FML_LOG(ERROR) << "--texture-test-count option requires an argument "
+                          "(e.g. --texture-test-count=4)";
+        return 1;
+      }
+      texture_test_config.count = std::stoul(count_str);
+      auto result = std::find(args.begin(), args.end(),
+                              "--texture-test-count=" + count_str);
+      if (result != args.end()) {
+        args.erase(result);
+      }
+    }
+    if (cl.HasOption("texture-test-size")) {
+      std::string size_str;
+      cl.GetOptionValue("texture-test-size", &size_str);
+      auto x = size_str.find('x');
+      if (x == std::string::npos) {
+        FML_LOG(ERROR) << "--texture-test-size option requires an argument "
+                          "(e.g. --texture-test-size=1920x1080)";
+        return 1;
+      }
+      texture_test_config.width = std::stoi(size_str.substr(0, x));
+      texture_test_config.height = std::stoi(size_str.substr(x + 1));
+      auto result = std::find(args.begin(), args.end(),
+                              "--texture-test-size=" + size_str);
+      if (result != args.end()) {
+        args.erase(result);
+      }
+    }
+    if (cl.HasOption("texture-test-format")) {
+      std::string format_str;
+      cl.GetOptionValue("texture-test-format", &format_str);
+      if (format_str != "rgb" && format_str != "rgba") {
+        FML_LOG(ERROR) << "--texture-test-format option requires rgb or rgba";
+        return 1;
+      }
+      texture_test_config.alpha = (format_str == "rgba");
+      auto result = std::find(args.begin(), args.end(),
+                              "--texture-test-format=" + format_str);
+      if (result != args.end()) {
+        args.erase(result);
+      }
+    }
+    if (cl.HasOption("texture-test-fps")) {
+      std::string fps_str;
+      cl.GetOptionValue("texture-test-fps", &fps_str);
+      if (fps_str.empty()) {
+        FML_LOG(ERROR) << "--texture-test-fps option requires an argument "
+                          "(e.g. --texture-test-fps=60)";
+        return 1;
+      }
+      texture_test_config.fps = std::stoul(fps_str);
+      auto result = std::find(args.begin(), args.end(),
+                              "--texture-test-fps=" + fps_str);
+      if (result != args.end()) {
+        args.erase(result);
+      }
+    }
+    if (cl.HasOption("texture-test-pattern")) {
+      std::string pattern_str;
+      cl.GetOptionValue("texture-test-pattern", &pattern_str);
+      if (!TextureTest::ParsePattern(pattern_str,
+                                     &texture_test_config.pattern)) {
+        FML_LOG(ERROR) << "--texture-test-pattern option requires gradient, "
+                          "checker or noise";
+        return 1;
+      }
+      auto result = std::find(args.begin(), args.end(),
+                              "--texture-test-pattern=" + pattern_str);
+      if (result != args.end()) {
+        args.erase(result);
+      }
+    }
+    TextureTest::SetConfig(texture_test_config);
+#endif
   }
   if (!width) {
     width = kScreenWidth;
@@ -0,0 +1,449 @@
+// Copyright 2020 Toyota Connected North America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Headless benchmark of the video player frame path: decode, plane upload
+// and YUV conversion/scaling with the shaders of the GStreamer plugin.
+// Renders into a surfaceless (or pbuffer) EGL context, so neither Wayland
+// nor a Flutter engine is needed; Mesa llvmpipe works.
+//
+//   gstreamer-benchmark [--sizes=640x360,1280x720,1920x1080]
+//                       [--format=NV12|I420|YUY2|P010_10LE]
+//                       [--frames=300] [--pattern=smpte] [--output=WxH]
+//                       [--uri=file:///path/to/clip.mp4]
+//
+// Stages per frame:
+//   wait     blocked on the appsink, i.e. source and decoder throughput
+//   upload   frame map and plane upload
+//   convert  conversion/scaling draw and glFinish
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl32.h>
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <flutter/fml/command_line.h>
+#include <flutter/fml/logging.h>
+
+#include "playback_stats.h"
+#include "yuv.h"
+
+namespace {
+
+struct Options {
+  std::vector<std::pair<int, int>> sizes{{640, 360}, {1280, 720}, {1920, 1080}};
+  std::string format = "NV12";
+  std::string pattern = "smpte";
+  std::string uri;
+  int frames = 300;
+  // 0 renders at the frame size
+  int output_width = 0;
+  int output_height = 0;
+};
+
+bool ParseSize(const std::string& str, int* width, int* height) {
+  return sscanf(str.c_str(), "%dx%d", width, height) == 2 && *width > 0 &&
+         *height > 0;
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t CpuNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Surfaceless display where EGL_MESA_platform_surfaceless is available,
+// else the default display.  Without EGL_KHR_surfaceless_context a 1x1
+// pbuffer is made current; rendering only targets framebuffer objects.
+class HeadlessEgl {
+ public:
+  ~HeadlessEgl() {
+    if (m_display == EGL_NO_DISPLAY) {
+      return;
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface != EGL_NO_SURFACE) {
+      eglDestroySurface(m_display, m_surface);
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+      eglDestroyContext(m_display, m_context);
+    }
+    eglTerminate(m_display);
+  }
+
+  bool Initialize() {
+    const char* client_extensions =
+        eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (client_extensions &&
+        strstr(client_extensions, "EGL_MESA_platform_surfaceless")) {
+      auto get_platform_display =
+          reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+              eglGetProcAddress("eglGetPlatformDisplayEXT"));
+      if (get_platform_display) {
+        m_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                         EGL_DEFAULT_DISPLAY, nullptr);
+      }
+    }
+    if (m_display == EGL_NO_DISPLAY) {
+      m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if (!eglInitialize(m_display, &major, &minor)) {
+      FML_LOG(ERROR) << "eglInitialize failed";
+      m_display = EGL_NO_DISPLAY;
+      return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+        EGL_NONE,
+    };
+    EGLConfig config;
+    EGLint n_configs = 0;
+    if (!eglChooseConfig(m_display, config_attribs, &config, 1, &n_configs) ||
+        n_configs == 0) {
+      FML_LOG(ERROR) << "No GLES3 capable EGL config";
+      return false;
+    }
+
+    // the player shaders are GLSL ES 3.20
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 2, EGL_NONE,
+    };
+    m_context =
+        eglCreateContext(m_display, config, EGL_NO_CONTEXT, context_attribs);
+    if (m_context == EGL_NO_CONTEXT) {
+      FML_LOG(ERROR) << "Failed to create a GLES 3.2 context";
+      return false;
+    }
+
+    const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+      const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+      m_surface = eglCreatePbufferSurface(m_display, config, pbuffer_attribs);
+    }
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+      FML_LOG(ERROR) << "eglMakeCurrent failed";
+      return false;
+    }
+    FML_LOG(INFO) << "EGL " << major << "." << minor << ", "
+                  << glGetString(GL_RENDERER);
+    return true;
+  }
+
+ private:
+  EGLDisplay m_display = EGL_NO_DISPLAY;
+  EGLContext m_context = EGL_NO_CONTEXT;
+  EGLSurface m_surface = EGL_NO_SURFACE;
+};
+
+// Output texture, framebuffer and quad, set up the same way as a player's
+// context in gstreamer.cc.
+class Target {
+ public:
+  Target(int width, int height) : m_width(width), m_height(height) {
+    glGenVertexArrays(1, &m_vertex_array);
+    glBindVertexArray(m_vertex_array);
+    glGenBuffers(2, m_buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(yuv::kQuadVertices),
+                 yuv::kQuadVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[1]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(yuv::kQuadTexcoords),
+                 yuv::kQuadTexcoords, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, width, height);
+    glGenFramebuffers(1, &m_framebuffer);
+    yuv::AttachFramebuffer(m_framebuffer, m_texture);
+
+    glViewport(-width / 2, -height / 2, width * 2, height * 2);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+  }
+
+  ~Target() {
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_texture);
+    glDeleteBuffers(2, m_buffers);
+    glDeleteVertexArrays(1, &m_vertex_array);
+  }
+
+  Target(const Target&) = delete;
+  const Target& operator=(const Target&) = delete;
+
+  [[nodiscard]] int GetWidth() const { return m_width; }
+  [[nodiscard]] int GetHeight() const { return m_height; }
+
+ private:
+  int m_width;
+  int m_height;
+  GLuint m_vertex_array{};
+  GLuint m_buffers[2]{};
+  GLuint m_texture{};
+  GLuint m_framebuffer{};
+};
+
+struct Run {
+  std::string source;
+  std::string format;
+  int output_width{};
+  int output_height{};
+  uint64_t frames{};
+  int64_t elapsed_ns{};
+  int64_t process_cpu_ns{};
+  int64_t thread_cpu_ns{};
+  playback::Histogram wait;
+  playback::Histogram upload;
+  playback::Histogram convert;
+};
+
+std::string PipelineDescription(const Options& options, int width, int height) {
+  std::stringstream ss;
+  if (!options.uri.empty()) {
+    ss << "uridecodebin uri=" << options.uri << " ! videoconvert";
+  } else {
+    ss << "videotestsrc num-buffers=" << options.frames
+       << " pattern=" << options.pattern << " ! video/x-raw,format="
+       << options.format << ",width=" << width << ",height=" << height
+       << ",framerate=1000/1";
+  }
+  ss << " ! appsink name=sink";
+  return ss.str();
+}
+
+// Pulls every frame of one pipeline through upload and conversion.  The
+// first frame carries pipeline start up and is not measured.
+bool RunPipeline(const Options& options, int width, int height, Run* run) {
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(
+      PipelineDescription(options, width, height).c_str(), &error);
+  if (pipeline == nullptr) {
+    FML_LOG(ERROR) << "Failed to build pipeline: "
+                   << (error ? error->message : "unknown");
+    g_clear_error(&error);
+    return false;
+  }
+  GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+  GstCaps* caps = gst_caps_from_string(yuv::kSinkCaps);
+  g_object_set(sink, "caps", caps, "sync", FALSE, "max-buffers", 2,
+               "emit-signals", FALSE, nullptr);
+  gst_caps_unref(caps);
+
+  GLuint programs[yuv::kFormatCount]{};
+  Target* target = nullptr;
+  yuv::Shader* shader = nullptr;
+  GstCaps* frame_caps = nullptr;
+  GstVideoInfo info{};
+  int64_t start_ns = 0, process_cpu_start = 0, thread_cpu_start = 0;
+  bool ok = true;
+
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  while (ok) {
+    int64_t wait_start = NowNs();
+    GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+    if (sample == nullptr) {
+      break;
+    }
+    int64_t upload_start = NowNs();
+
+    GstCaps* sample_caps = gst_sample_get_caps(sample);
+    if (sample_caps != frame_caps) {
+      gst_video_info_from_caps(&info, sample_caps);
+      if (frame_caps) {
+        gst_caps_unref(frame_caps);
+      }
+      frame_caps = gst_caps_ref(sample_caps);
+    }
+    yuv::Format format;
+    if (!yuv::FromVideoFormat(GST_VIDEO_INFO_FORMAT(&info), &format)) {
+      FML_LOG(ERROR) << "Unsupported frame format";
+      gst_sample_unref(sample);
+      ok = false;
+      break;
+    }
+    if (target == nullptr) {
+      target = new Target(
+          options.output_width > 0 ? options.output_width : info.width,
+          options.output_height > 0 ? options.output_height : info.height);
+    }
+    if (shader == nullptr || !shader->Matches(format, &info)) {
+      if (programs[format] == 0) {
+        programs[format] = yuv::CreateProgram(format);
+      }
+      delete shader;
+      shader = new yuv::Shader(programs[format], format, &info);
+      shader->Bind();
+    }
+
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, &info, gst_sample_get_buffer(sample),
+                             GST_MAP_READ)) {
+      FML_LOG(ERROR) << "Cannot map video frame";
+      gst_sample_unref(sample);
+      ok = false;
+      break;
+    }
+    shader->LoadFrame(&frame);
+    gst_video_frame_unmap(&frame);
+    gst_sample_unref(sample);
+
+    int64_t convert_start = NowNs();
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glFinish();
+    int64_t convert_end = NowNs();
+
+    if (start_ns == 0) {
+      start_ns = convert_end;
+      process_cpu_start = CpuNs(CLOCK_PROCESS_CPUTIME_ID);
+      thread_cpu_start = CpuNs(CLOCK_THREAD_CPUTIME_ID);
+      run->source =
+          std::to_string(info.width) + "x" + std::to_string(info.height);
+      run->format = gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&info));
+      run->output_width = target->GetWidth();
+      run->output_height = target->GetHeight();
+      continue;
+    }
+    run->wait.Add(upload_start - wait_start);
+    run->upload.Add(convert_start - upload_start);
+    run->convert.Add(convert_end - convert_start);
+    run->frames++;
+  }
+  if (start_ns) {
+    run->elapsed_ns = NowNs() - start_ns;
+    run->process_cpu_ns = CpuNs(CLOCK_PROCESS_CPUTIME_ID) - process_cpu_start;
+    run->thread_cpu_ns = CpuNs(CLOCK_THREAD_CPUTIME_ID) - thread_cpu_start;
+  }
+
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  if (frame_caps) {
+    gst_caps_unref(frame_caps);
+  }
+  delete shader;
+  delete target;
+  for (auto program : programs) {
+    if (program) {
+      glDeleteProgram(program);
+    }
+  }
+  gst_object_unref(sink);
+  gst_object_unref(pipeline);
+  return ok && run->frames > 0;
+}
+
+void PrintHeader() {
+  printf("%-10s %-10s %-10s %8s %17s %17s %17s %8s %8s\n", "source",
+         "format", "output", "fps", "wait mean/p99", "upload mean/p99",
+         "convert mean/p99", "cpu %", "render %");
+}
+
+void PrintRun(const Run& run) {
+  double seconds = static_cast<double>(run.elapsed_ns) / 1e9;
+  auto stage = [](const playback::Histogram& histogram) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%7.0f/%-7ld", histogram.MeanUs(),
+             static_cast<long>(histogram.PercentileUs(0.99)));
+    return std::string(buf);
+  };
+  std::string output = std::to_string(run.output_width) + "x" +
+                       std::to_string(run.output_height);
+  printf("%-10s %-10s %-10s %8.1f %17s %17s %17s %8.1f %8.1f\n",
+         run.source.c_str(), run.format.c_str(), output.c_str(),
+         seconds > 0 ? run.frames / seconds : 0.0, stage(run.wait).c_str(),
+         stage(run.upload).c_str(), stage(run.convert).c_str(),
+         seconds > 0 ? 100.0 * run.process_cpu_ns / run.elapsed_ns : 0.0,
+         seconds > 0 ? 100.0 * run.thread_cpu_ns / run.elapsed_ns : 0.0);
+  fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  auto cl = fml::CommandLineFromArgcArgv(argc, argv);
+
+  std::string value;
+  if (cl.GetOptionValue("sizes", &value)) {
+    options.sizes.clear();
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      int width, height;
+      if (!ParseSize(item, &width, &height)) {
+        FML_LOG(ERROR) << "--sizes expects WxH[,WxH...] (e.g. "
+                          "--sizes=1280x720,1920x1080)";
+        return 1;
+      }
+      options.sizes.emplace_back(width, height);
+    }
+  }
+  if (cl.GetOptionValue("output", &value) &&
+      !ParseSize(value, &options.output_width, &options.output_height)) {
+    FML_LOG(ERROR) << "--output expects WxH (e.g. --output=1280x720)";
+    return 1;
+  }
+  if (cl.GetOptionValue("frames", &value)) {
+    options.frames = std::stoi(value);
+  }
+  cl.GetOptionValue("format", &options.format);
+  cl.GetOptionValue("pattern", &options.pattern);
+  cl.GetOptionValue("uri", &options.uri);
+
+  gst_init(&argc, &argv);
+
+  HeadlessEgl egl;
+  if (!egl.Initialize()) {
+    return 1;
+  }
+
+  // a clip is measured once at its own size
+  if (!options.uri.empty()) {
+    options.sizes = {{0, 0}};
+  }
+
+  PrintHeader();
+  int result = 0;
+  for (const auto& [width, height] : options.sizes) {
+    Run run;
+    if (!RunPipeline(options, width, height, &run)) {
+      FML_LOG(ERROR) << "Run failed at " << width << "x" << height;
+      result = 1;
+      continue;
+    }
+    PrintRun(run);
+  }
+  return result;
+}
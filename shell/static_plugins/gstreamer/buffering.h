@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <flutter/fml/logging.h>
+#include <gst/gst.h>
+
+namespace buffering {
+
+// There is no automated test.  To check a profile against a local server:
+//
+//   python3 -m http.server 8000 --directory <dir with a large mp4>
+//   GST_DEBUG=queue2:5 GSTREAMER_BUFFERING_PROFILE=download <app>
+//
+// and create a player for http://127.0.0.1:8000/<file>.  The queue2 log
+// shows the watermarks and, for download profiles, the temp file and the
+// ranges fetched; bufferingStart/bufferingEnd reach Dart around prefetch.
+// Throttling the link (tc qdisc ... netem rate 1mbit) shows the stalls.
+
+// Network buffering of a player.  Applied to playbin before the uri is
+// opened; the queue2 settings are applied as uridecodebin creates it.
+struct Profile {
+  const char* name;
+  // playbin "buffer-size" (bytes) and "buffer-duration" (ns), -1 default
+  gint buffer_size;
+  gint64 buffer_duration;
+  // progressive download into a file under the cache dir, bounded by the
+  // ring buffer size when not 0
+  bool download;
+  guint64 ring_buffer_max_size;
+  // queue2 watermarks as a fraction of the buffer, negative keeps the
+  // element default
+  gdouble low_watermark;
+  gdouble high_watermark;
+  // adaptive stream bitrate hint in kbps, 0 lets playbin estimate it
+  guint64 connection_speed;
+  // stream time buffered ahead before buffering ends the first time
+  gint64 prefetch;
+};
+
+constexpr Profile kProfiles[] = {
+    // playbin defaults
+    {"default", -1, -1, false, 0, -1.0, -1.0, 0, 0},
+    // short in-memory buffer, starts quickly on a good link
+    {"stream", 4 * 1024 * 1024, 5 * GST_SECOND, false, 0, 0.10, 0.99, 0,
+     2 * GST_SECOND},
+    // downloads ahead to disk, survives long stalls
+    {"download", -1, 10 * GST_SECOND, true, 64 * 1024 * 1024, 0.05, 0.60, 0,
+     10 * GST_SECOND},
+    // weak or intermittent links, deep buffer and a long prefetch
+    {"weak", 8 * 1024 * 1024, 30 * GST_SECOND, true, 128 * 1024 * 1024, 0.20,
+     0.99, 0, 15 * GST_SECOND},
+};
+
+// Profile by name.  Without one, GSTREAMER_BUFFERING_PROFILE selects the
+// default; unknown names fall back to "default".
+inline const Profile& Lookup(const char* name) {
+  if (name == nullptr || *name == '\0') {
+    name = getenv("GSTREAMER_BUFFERING_PROFILE");
+  }
+  if (name != nullptr) {
+    for (const auto& profile : kProfiles) {
+      if (strcmp(profile.name, name) == 0) {
+        return profile;
+      }
+    }
+    FML_LOG(ERROR) << "Unknown buffering profile: " << name;
+  }
+  return kProfiles[0];
+}
+
+// Buffering state of one player, passed to OnElementSetup.
+struct Config {
+  const Profile* profile = &kProfiles[0];
+  // template of the download file, see queue2 "temp-template"
+  std::string temp_template;
+};
+
+// playbin "element-setup" handler, configures the network queue.
+inline void OnElementSetup(GstElement* playbin,
+                           GstElement* element,
+                           gpointer user_data) {
+  auto config = static_cast<const Config*>(user_data);
+  GstElementFactory* factory = gst_element_get_factory(element);
+  if (factory == nullptr ||
+      std::string("queue2") !=
+          gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory))) {
+    return;
+  }
+  const Profile* profile = config->profile;
+  if (profile->low_watermark >= 0 && profile->high_watermark >= 0) {
+#if GST_CHECK_VERSION(1, 10, 0)
+    g_object_set(element, "low-watermark", profile->low_watermark,
+                 "high-watermark", profile->high_watermark, nullptr);
+#else
+    g_object_set(element, "low-percent",
+                 static_cast<gint>(profile->low_watermark * 100),
+                 "high-percent",
+                 static_cast<gint>(profile->high_watermark * 100), nullptr);
+#endif
+  }
+  if (profile->download && !config->temp_template.empty()) {
+    g_object_set(element, "temp-template", config->temp_template.c_str(),
+                 "temp-remove", TRUE, nullptr);
+  }
+}
+
+}  // namespace buffering
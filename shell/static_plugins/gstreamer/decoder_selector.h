@@ -0,0 +1,255 @@
+/*
+ * Copyright 2020 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <flutter/fml/logging.h>
+#include <gst/gst.h>
+
+namespace decoder {
+
+// Video decoder name patterns, best first.  Overridden with
+// GSTREAMER_DECODER_PREFERENCE, decoders matching GSTREAMER_DECODER_DENY
+// are never used.  Anything not listed keeps its registry rank, so
+// software decoders (dav1d, vpx, avdec_*) keep the order their plugins
+// ship with.
+constexpr char kDefaultPreference[] = "v4l2*,va*,nv*,omx*,imx*";
+
+// Hardware decoders whose element class does not say so.
+constexpr char kHardwareDecoders[] = "v4l2*,va*,nv*,omx*,imx*,msdk*";
+
+// autoplug candidate lists kept, the cache starts over when full
+constexpr size_t kMaxCachedCaps = 64;
+
+// Orders autoplug candidates per pipeline.  The registry ranks are left
+// alone, so pipelines that are not hooked autoplug as usual.
+class Selector {
+ public:
+  static Selector& GetInstance() {
+    static Selector instance;
+    return instance;
+  }
+
+  Selector(const Selector&) = delete;
+  const Selector& operator=(const Selector&) = delete;
+
+  // Ranks the installed decoders and builds the list of autoplug
+  // candidates.  Runs once per process, after gst_init().
+  void Initialize() { std::call_once(m_init_flag, [this] { Init(); }); }
+
+  // playbin "element-setup" handler of players, hooks every decodebin it
+  // creates; preferred decoders are tried first.
+  static void OnElementSetup(GstElement* playbin,
+                             GstElement* element,
+                             gpointer user_data) {
+    Hook(element, false);
+  }
+
+  // playbin "element-setup" handler of background pipelines, which only
+  // use software decoders and leave the hardware instances to players.
+  static void OnSoftwareElementSetup(GstElement* playbin,
+                                     GstElement* element,
+                                     gpointer user_data) {
+    Hook(element, true);
+  }
+
+ private:
+  struct Candidate {
+    GstElementFactory* factory;
+    guint rank;
+    bool hardware;
+  };
+
+  std::once_flag m_init_flag;
+  std::vector<Candidate> m_candidates;
+
+  std::mutex m_cache_mutex;
+  std::map<std::string, std::vector<GstElementFactory*>> m_cache;
+
+  Selector() = default;
+  ~Selector() = default;
+
+  static void Hook(GstElement* element, bool software) {
+    GstElementFactory* factory = gst_element_get_factory(element);
+    if (factory == nullptr ||
+        std::string("decodebin") !=
+            gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory))) {
+      return;
+    }
+    g_signal_connect(element, "autoplug-factories",
+                     G_CALLBACK(OnAutoplugFactories),
+                     GINT_TO_POINTER(software));
+  }
+
+  static std::vector<std::string> Split(const char* list) {
+    std::vector<std::string> result;
+    std::stringstream ss(list ? list : "");
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      if (!item.empty()) {
+        result.push_back(item);
+      }
+    }
+    return result;
+  }
+
+  static bool Matches(const std::vector<std::string>& patterns,
+                      const char* name,
+                      size_t* index = nullptr) {
+    for (size_t i = 0; i < patterns.size(); i++) {
+      if (fnmatch(patterns[i].c_str(), name, 0) == 0) {
+        if (index) {
+          *index = i;
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Init() {
+    const char* env = getenv("GSTREAMER_DECODER_PREFERENCE");
+    auto preference = Split(env ? env : kDefaultPreference);
+    auto deny = Split(getenv("GSTREAMER_DECODER_DENY"));
+    auto hardware = Split(kHardwareDecoders);
+
+    // Same candidate set decodebin builds for itself, plus preferred
+    // decoders below marginal rank.  Preferred decoders rank above
+    // everything the registry ships with, denied ones are left out.
+    GList* factories = gst_element_factory_list_get_elements(
+        GST_ELEMENT_FACTORY_TYPE_DECODABLE, GST_RANK_NONE);
+    for (GList* l = factories; l != nullptr; l = l->next) {
+      auto factory = GST_ELEMENT_FACTORY(l->data);
+      const char* name =
+          gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory));
+      guint rank = gst_plugin_feature_get_rank(GST_PLUGIN_FEATURE(factory));
+      bool video_decoder = gst_element_factory_list_is_type(
+          factory, GST_ELEMENT_FACTORY_TYPE_DECODER |
+                       GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO);
+      size_t index;
+      if (video_decoder && Matches(deny, name)) {
+        continue;
+      }
+      if (video_decoder && Matches(preference, name, &index)) {
+        rank = GST_RANK_PRIMARY + 16 * (preference.size() - index);
+      } else if (rank < GST_RANK_MARGINAL) {
+        continue;
+      }
+      const char* klass =
+          gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+      bool is_hardware =
+          video_decoder && ((klass && strstr(klass, "Hardware")) ||
+                            Matches(hardware, name));
+      m_candidates.push_back({GST_ELEMENT_FACTORY(gst_object_ref(factory)),
+                              rank, is_hardware});
+    }
+    gst_plugin_feature_list_free(factories);
+
+    std::sort(m_candidates.begin(), m_candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                if (a.rank != b.rank) {
+                  return a.rank > b.rank;
+                }
+                return strcmp(GST_OBJECT_NAME(a.factory),
+                              GST_OBJECT_NAME(b.factory)) < 0;
+              });
+
+    std::stringstream ss;
+    for (const auto& candidate : m_candidates) {
+      if (gst_element_factory_list_is_type(
+              candidate.factory, GST_ELEMENT_FACTORY_TYPE_DECODER |
+                                     GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO)) {
+        ss << " " << GST_OBJECT_NAME(candidate.factory) << "("
+           << candidate.rank << (candidate.hardware ? ",hw" : "") << ")";
+      }
+    }
+    FML_LOG(INFO) << "Video decoders:" << ss.str();
+  }
+
+  // Candidates depend only on the media type and profile: decodebin checks
+  // fixed caps against every candidate's templates itself.
+  std::vector<GstElementFactory*> GetFactories(GstCaps* caps, bool software) {
+    if (gst_caps_is_empty(caps) || gst_caps_is_any(caps)) {
+      return {};
+    }
+    GstStructure* structure = gst_caps_get_structure(caps, 0);
+    const char* media_type = gst_structure_get_name(structure);
+    const char* profile = gst_structure_get_string(structure, "profile");
+    std::string key(media_type);
+    if (profile) {
+      key.append(":").append(profile);
+    }
+    if (software) {
+      key.append(":software");
+    }
+
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    auto search = m_cache.find(key);
+    if (search != m_cache.end()) {
+      return search->second;
+    }
+    GstCaps* filter = gst_caps_new_empty_simple(media_type);
+    if (profile) {
+      gst_caps_set_simple(filter, "profile", G_TYPE_STRING, profile, nullptr);
+    }
+    std::vector<GstElementFactory*> factories;
+    for (const auto& candidate : m_candidates) {
+      if (!(software && candidate.hardware) &&
+          gst_element_factory_can_sink_any_caps(candidate.factory, filter)) {
+        factories.push_back(candidate.factory);
+      }
+    }
+    gst_caps_unref(filter);
+    if (m_cache.size() >= kMaxCachedCaps) {
+      m_cache.clear();
+    }
+    m_cache[key] = factories;
+    return factories;
+  }
+
+  static GValueArray* OnAutoplugFactories(GstElement* bin,
+                                          GstPad* pad,
+                                          GstCaps* caps,
+                                          gpointer user_data) {
+    auto factories =
+        GetInstance().GetFactories(caps, GPOINTER_TO_INT(user_data) != 0);
+
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+    GValueArray* result = g_value_array_new(factories.size());
+    for (auto factory : factories) {
+      GValue val = G_VALUE_INIT;
+      g_value_init(&val, GST_TYPE_ELEMENT_FACTORY);
+      g_value_set_object(&val, factory);
+      g_value_array_append(result, &val);
+      g_value_unset(&val);
+    }
+    G_GNUC_END_IGNORE_DEPRECATIONS
+    return result;
+  }
+};
+
+}  // namespace decoder
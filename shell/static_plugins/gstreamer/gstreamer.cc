@@ -5,86 +5,377 @@
 #include <flutter/fml/paths.h>
 #include <flutter/standard_message_codec.h>
 #include <flutter/standard_method_codec.h>
+#include <gst/app/gstappsink.h>
 #include <gst/gst.h>
 #include <gst/video/video.h>
-extern "C" {
-#include <libavformat/avformat.h>
-}
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <future>
+#include <list>
+#include <shared_mutex>
 #include <thread>
+#include <vector>
 
+#include "buffering.h"
+#include "decoder_selector.h"
+#include "egl_window.h"
 #include "engine.h"
 #include "hexdump.h"
-#include "nv12.h"
+#include "keyframe_index.h"
+#include "playback_stats.h"
 #include "platform_channel.h"
 #include "textures/texture.h"
+#include "thumbnailer.h"
+#include "yuv.h"
 
 #define GSTREAMER_DEBUG 0
 
 using namespace fml;
 
-static GLuint vertexShader, fragmentShader;
+// Programs and quad geometry shared by all players.  They live in the share
+// group of the engine context, so any player context can use them.  Each
+// player holds a reference; the last one out deletes them.  Programs are
+// built the first time a stream of their format shows up.
+struct SharedGLResources {
+  GLuint programs[yuv::kFormatCount]{};
+  GLuint vertexbuffer{};
+  GLuint coordbuffer{};
+  size_t refs{};
+};
 
-static GLuint vertex_arr_id;
+static std::mutex gl_resources_mutex;
+static SharedGLResources gl_resources;
 
-static GLuint vertexbuffer;
-static GLuint coordbuffer;
+bool acquire_gl_resources();
+void release_gl_resources();
+GLuint get_program(yuv::Format format);
 
 constexpr char kUriPrefixFile[] = "file://";
 
-static const GLchar* vertexSource = R"glsl(
-  #version 320 es
-  precision highp float;
+// a scrub seek without ASYNC_DONE after this long no longer holds back
+// the queued one
+constexpr auto kScrubSeekTimeout = std::chrono::milliseconds(500);
 
-  layout(location = 0) in vec3 vertexPosition_modelspace;
-  in vec2 texcoord;
-  out vec2 Texcoord;
-  void main()
-  {
-    Texcoord = texcoord;
-    gl_Position.xyz = vertexPosition_modelspace;
-    gl_Position.w = 1.0;
-  }
-)glsl";
+// decoded frames queued ahead of the render worker
+constexpr guint kAppSinkMaxBuffers = 2;
+
+// jitterbuffer latency of live RTSP feeds
+constexpr guint kLiveLatencyMs = 20;
 
+// warm players kept for reuse, see player_pool_size()
+constexpr int kDefaultPlayerPoolSize = 2;
+
+// player ids start here, above any GL texture name in the engine registry
+constexpr int64_t kPlayerIdBase = 1 << 30;
+
+// playbin flags, see gstplay-enum.h
 typedef enum {
-  GST_PLAY_FLAG_AUDIO = (1 << 0),
-  GST_PLAY_FLAG_VIDEO = (1 << 1),
-  GST_PLAY_FLAG_TEXT = (1 << 2)
+  GST_PLAY_FLAG_VIDEO = (1 << 0),
+  GST_PLAY_FLAG_AUDIO = (1 << 1),
+  GST_PLAY_FLAG_TEXT = (1 << 2),
+  GST_PLAY_FLAG_DOWNLOAD = (1 << 7)
 } GstPlayFlags;
 
 class CustomData {
  public:
-  bool initialized = false;
-  GstElement *pipeline{}, *playbin{}, *decoder{}, *videoconvert{},
-      *videoscale{}, *sink{};
+  std::atomic<bool> initialized = false;
+  GstElement *pipeline{}, *playbin{}, *videoconvert{}, *videoscale{}, *sink{};
   GMainLoop* main_loop{};
   gint n_video{};
   gint current_video{};
   gint width{}, height{};
+  // stream info from the decoder, and the caps and layout of the frames
+  // reaching the render worker
   GstVideoInfo info{};
-  AVCodecID codec_id{};
+  GstCaps* frame_caps{};
+  GstVideoInfo frame_info{};
   gint64 position = 0, duration = 0;
+  // stream time of the frame last rendered, -1 before the first one
+  std::atomic<gint64> frame_position = -1;
   gdouble rate = 0.0;
   std::string uri;
   Texture* texture{};
+  // registry key, Flutter texture id and event channel suffix, counted from
+  // kPlayerIdBase; 0 while parked
+  std::atomic<int64_t> id = 0;
+  // requested by the app: no video branch or texture, see main_loop().
+  // Otherwise the producer context and render worker wait for a video
+  // stream, see start_video().
+  bool audio_only = false;
   std::thread gthread;
-  nv12::Shader* shader{};
+  yuv::Shader* shader{};
   Engine* engine{};
-  //  std::promise<void> barrier;
-  //  std::future<void> barrier_fut;
+  // producer context, current on the render worker
+  EGLContext egl_context = EGL_NO_CONTEXT;
+  GLuint vertex_arr_id{};
+  GLuint framebuffer{};
+  // per-context objects exist; they outlive streams of a pooled player
+  bool context_ready = false;
+  // per-player lock, guards info and the player's GL objects so players
+  // render independently of each other
+  std::mutex frame_mutex;
+  // render worker, pulls the newest sample from the appsink
+  std::thread render_thread;
+  std::mutex render_mutex;
+  std::condition_variable render_cv;
+  bool render_pending = false;
+  bool preroll_pending = false;
+  bool render_stop = false;
+  // output textures of disposed streams, still attached to the player's
+  // framebuffer; detached and deleted by the render worker
+  std::vector<GLuint> stale_textures;
+  // frames are published on display frames, see configure_sink()
+  std::atomic<bool> scheduled = true;
+  // texture memory over budget, see on_memory_pressure().  The output is
+  // rendered at width and height >> output_shift; applied_shift is the
+  // size of the current output texture, render worker only.
+  std::atomic<bool> low_memory = false;
+  std::atomic<int> output_shift = 0;
+  int applied_shift = 0;
+  // last buffer in the texture, so the preroll buffer is not uploaded a
+  // second time when playback starts; guarded by frame_mutex
+  GstBuffer* last_buffer{};
+  playback::Stats stats;
+  // player main context and the optional periodic stats event source
+  GMainContext* context{};
+  GSource* stats_source{};
+  // push mode: the player thread publishes the position and OnPosition
+  // replies with the last encoded reply, see set_position_interval()
+  std::mutex position_mutex;
+  GSource* position_source{};
+  std::vector<uint8_t> position_reply;
+  std::vector<std::pair<int64_t, int64_t>> buffered;
+  // per-stream reporting, see stream_stats_period()
+  struct {
+    uint64_t frames;
+    int64_t period_start_ns;
+    int64_t thread_cpu_start_ns;
+    int64_t render_cpu_ns;
+  } stream_stats{};
+  // set by main_loop once the pipeline exists
+  std::promise<void> barrier;
+  std::future<void> barrier_fut;
+  // is_live: low-latency camera feed, see configure_live()
   bool is_looping = false, is_buffering = false, is_live = false;
-  bool events_enabled = false;
+  // network buffering, see apply_buffering(); `prefetched` once the
+  // profile's prefetch was buffered, checked by prefetch_source until then
+  buffering::Config buffering;
+  bool prefetched = false;
+  GSource* prefetch_source{};
+  std::atomic<bool> events_enabled = false;
+  std::atomic<bool> initialized_sent = false;
+  // the stream's first frame is in the texture; `initialized` waits for it
+  std::atomic<bool> first_frame = false;
+  std::chrono::steady_clock::time_point create_time;
+  // scrubbing, see scrub_seek(); guarded by seek_mutex
+  std::mutex seek_mutex;
+  bool scrubbing = false;
+  bool seek_in_flight = false;
+  std::chrono::steady_clock::time_point seek_issued;
+  gint64 seek_target = -1, scrub_position = -1, scrub_keyframe = -1;
+  std::shared_ptr<keyframe::Index> keyframes;
+  // output texture set up by the render worker once the stream size is known
+  bool gl_ready = false;
   GstState target_state = GST_STATE_PAUSED;
   double volume = 0.0;
-  CustomData() : gthread{} {}
+  CustomData() : gthread{}, barrier_fut{barrier.get_future()} {}
   CustomData(CustomData&&) = default;
 };
 
+// GSTREAMER_VSYNC_PRESENT=0 shows frames as the appsink releases them
+// instead of scheduling them on display frames.
+static bool vsync_presentation() {
+  static const bool enabled = [] {
+    const char* env = getenv("GSTREAMER_VSYNC_PRESENT");
+    return env == nullptr || atoi(env) != 0;
+  }();
+  return enabled;
+}
+
+// Live feeds are shown as they are decoded: no clock sync, and a single
+// frame queue that drops the older frame.  Otherwise the render worker
+// schedules frames and the appsink only queues them, blocking the decoder
+// when full; or, with vsync presentation off, the appsink syncs and drops
+// the oldest frame when the render worker falls behind, late frames are
+// dropped by the sink and reported upstream as QoS.
+static void configure_sink(CustomData* data) {
+  data->scheduled = !data->is_live && vsync_presentation();
+  guint max_buffers = data->low_memory ? 1u : kAppSinkMaxBuffers;
+  if (data->is_live) {
+    g_object_set(data->sink, "sync", FALSE, "max-buffers", 1u, "drop", TRUE,
+                 "qos", FALSE, nullptr);
+  } else if (data->scheduled) {
+    g_object_set(data->sink, "sync", FALSE, "max-buffers", max_buffers,
+                 "drop", FALSE, "qos", FALSE, nullptr);
+  } else {
+    g_object_set(data->sink, "sync", TRUE, "max-buffers", max_buffers,
+                 "drop", TRUE, "qos", TRUE, "max-lateness",
+                 static_cast<gint64>(20 * GST_MSECOND), nullptr);
+  }
+}
+
+// Limits the frame size to what the shaders scale without aliasing, see
+// yuv::SinkCaps().  Set while the pipeline is at most READY.
+static void set_sink_caps(CustomData* data) {
+  GstCaps* caps = yuv::SinkCaps(data->width, data->height);
+  g_object_set(data->sink, "caps", caps, nullptr);
+  gst_caps_unref(caps);
+}
+
+static bool is_live_uri(const std::string& uri) {
+  for (const char* scheme :
+       {"rtsp://", "rtsps://", "rtspt://", "rtp://", "udp://", "srt://"}) {
+    if (uri.rfind(scheme, 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void set_if_exists(GstElement* element,
+                          const char* property,
+                          gint value) {
+  if (g_object_class_find_property(G_OBJECT_GET_CLASS(element), property)) {
+    g_object_set(element, property, value, nullptr);
+  }
+}
+
+// playbin "element-setup" handler: for live feeds queues hold at most a
+// couple of buffers and leak the oldest, and decoders output each frame
+// as soon as it is decoded.
+static void live_element_setup(GstElement* playbin,
+                               GstElement* element,
+                               CustomData* data) {
+  GstElementFactory* factory = gst_element_get_factory(element);
+  if (!data->is_live || factory == nullptr) {
+    return;
+  }
+  std::string name = gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory));
+  if (name == "queue") {
+    g_object_set(element, "leaky", 2 /* downstream */, "max-size-buffers", 2u,
+                 "max-size-bytes", 0u, "max-size-time",
+                 static_cast<guint64>(0), nullptr);
+  } else if (name == "queue2" || name == "multiqueue") {
+    g_object_set(element, "use-buffering", FALSE, "max-size-buffers", 2u,
+                 "max-size-bytes", 0u, "max-size-time",
+                 static_cast<guint64>(0), nullptr);
+  } else if (gst_element_factory_list_is_type(
+                 factory, GST_ELEMENT_FACTORY_TYPE_DECODER |
+                              GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO)) {
+    // va/vaapi decoders
+    set_if_exists(element, "low-latency", TRUE);
+    // libav: slice threads add no frame delay, unlike frame threads
+    set_if_exists(element, "thread-type", 2 /* slice */);
+  }
+}
+
+// playbin "source-setup" handler: RTSP jitterbuffer sized for a wired
+// camera, late packets are dropped rather than waited for.
+static void live_source_setup(GstElement* playbin,
+                              GstElement* source,
+                              CustomData* data) {
+  if (!data->is_live) {
+    return;
+  }
+  if (g_object_class_find_property(G_OBJECT_GET_CLASS(source), "latency")) {
+    g_object_set(source, "latency", kLiveLatencyMs, nullptr);
+  }
+  set_if_exists(source, "drop-on-latency", TRUE);
+}
+
+// serializes player creation
 static std::mutex gst_mutex;
 
+// Player registry.  Platform handlers and bus threads take a reference to
+// the player under a shared lock; the registry lock is never held while a
+// player is in use.
+static std::shared_mutex global_map_mutex;
 static std::map<int64_t, std::shared_ptr<CustomData>> global_map;
 
+static std::shared_ptr<CustomData> find_player(int64_t textureId) {
+  std::shared_lock<std::shared_mutex> lock(global_map_mutex);
+  auto search = global_map.find(textureId);
+  if (search == global_map.end()) {
+    return nullptr;
+  }
+  return search->second;
+}
+
+static void add_player(int64_t textureId, std::shared_ptr<CustomData> data) {
+  std::unique_lock<std::shared_mutex> lock(global_map_mutex);
+  global_map[textureId] = std::move(data);
+}
+
+static std::shared_ptr<CustomData> remove_player(int64_t textureId) {
+  std::unique_lock<std::shared_mutex> lock(global_map_mutex);
+  auto search = global_map.find(textureId);
+  if (search == global_map.end()) {
+    return nullptr;
+  }
+  auto data = std::move(search->second);
+  global_map.erase(search);
+  return data;
+}
+
+// Output texture size, reduced under texture memory pressure.
+static gint output_width(const CustomData* data, int shift) {
+  return std::max(data->width >> shift, 1);
+}
+
+static gint output_height(const CustomData* data, int shift) {
+  return std::max(data->height >> shift, 1);
+}
+
+// Texture memory pressure callback, runs on whichever thread crossed the
+// budget, possibly with another player's frame_mutex held.  Over budget the
+// player first gives up its queued decoded frames, which hardware decoders
+// keep in video memory.  When the excess is a sizeable part of its own
+// textures it also renders at half size, a quarter of the output texture.
+// Back under budget the queue is restored, and the full size if it fits.
+static void on_memory_pressure(Texture* texture, size_t over_budget) {
+  auto data = find_player(texture->GetId());
+  if (!data || data->sink == nullptr) {
+    return;
+  }
+  if (over_budget == 0) {
+    if (data->low_memory.exchange(false)) {
+      configure_sink(data.get());
+    }
+    int shift = data->output_shift;
+    if (shift == 0) {
+      return;
+    }
+    auto bytes = [&](int s) {
+      return Texture::CalculateMemorySize(GL_RGB, output_width(data.get(), s),
+                                          output_height(data.get(), s));
+    };
+    if (bytes(0) - bytes(shift) <=
+        data->engine->GetTextureMemoryHeadroom()) {
+      FML_LOG(INFO) << "(" << data->id << ") texture memory under budget, "
+                    << "full size output";
+      data->output_shift = 0;
+    }
+    return;
+  }
+  if (!data->low_memory.exchange(true)) {
+    FML_LOG(INFO) << "(" << data->id << ") texture memory " << over_budget
+                  << " bytes over budget, queueing a single frame";
+    configure_sink(data.get());
+  }
+  if (over_budget >= texture->GetMemoryUsage() / 4 &&
+      data->output_shift == 0) {
+    FML_LOG(INFO) << "(" << data->id << ") texture memory " << over_budget
+                  << " bytes over budget, half size output";
+    data->output_shift = 1;
+  }
+}
+
 void PrintMessageAsHex(const FlutterPlatformMessage* message) {
 #if GSTREAMER_DEBUG
   std::stringstream ss;
@@ -106,189 +397,1166 @@ void SendSuccess(Engine* engine,
                                       encoded->size());
 }
 
-bool get_video_info(const char* url,
-                    int& width,
-                    int& height,
-                    gint64& duration,
-                    AVCodecID& codec_id) {
-  AVFormatContext* fmt_ctx = avformat_alloc_context();
+// The player owns its context, so framebuffer, viewport and vertex array
+// state is set once here and survives between frames.  The viewport is
+// the output size, the shader scales the frame into it.
+void setup_render_state(CustomData* data) {
+  glBindVertexArray(data->vertex_arr_id);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, gl_resources.vertexbuffer);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glEnableVertexAttribArray(1);
+  glBindBuffer(GL_ARRAY_BUFFER, gl_resources.coordbuffer);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, data->framebuffer);
+  // the quad covers the whole viewport, so frames never need a clear
+  gint width = output_width(data, data->applied_shift);
+  gint height = output_height(data, data->applied_shift);
+  glViewport(-width / 2, -height / 2, width * 2, height * 2);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+}
+
+void draw_core() {
+  glDrawArrays(GL_TRIANGLES, 0, 6);
+  // the engine samples the texture from another context
+  glFinish();
+}
+
+// GSTREAMER_STREAM_STATS=<seconds> logs frame rate and CPU use of every
+// stream, e.g. to find how many concurrent players a SoC sustains.
+static int64_t stream_stats_period() {
+  static const int64_t period_ns = [] {
+    const char* env = getenv("GSTREAMER_STREAM_STATS");
+    int val = env ? atoi(env) : 0;
+    return val > 0 ? static_cast<int64_t>(val) * 1000000000 : 0;
+  }();
+  return period_ns;
+}
+
+static int64_t thread_cpu_ns() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Called on the render worker after each rendered frame.  Thread CPU is
+// the worker's upload and render cost.
+static void update_stream_stats(CustomData* data,
+                                int64_t textureId,
+                                int64_t render_cpu_ns) {
+  auto& stats = data->stream_stats;
+  int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+  int64_t cpu = thread_cpu_ns();
+  if (stats.period_start_ns == 0) {
+    stats = {0, now, cpu, 0};
+    return;
+  }
+  stats.frames++;
+  stats.render_cpu_ns += render_cpu_ns;
+
+  int64_t elapsed = now - stats.period_start_ns;
+  if (elapsed < stream_stats_period()) {
+    return;
+  }
+  FML_LOG(INFO) << "stream " << textureId << ": "
+                << (static_cast<double>(stats.frames) * 1e9 / elapsed)
+                << " fps, render thread cpu "
+                << (100.0 * (cpu - stats.thread_cpu_start_ns) / elapsed)
+                << "%, render "
+                << (static_cast<double>(stats.render_cpu_ns) / 1e6 /
+                    stats.frames)
+                << " ms/frame, dropped " << data->stats.FramesDropped();
+  stats = {0, now, cpu, 0};
+}
+
+// Sends `initialized` once the first frame is in the texture and Dart
+// listens; whichever of the two happens last sends it.
+static void send_initialized_event(CustomData* data) {
+  if (!data->initialized || !data->first_frame || !data->events_enabled ||
+      data->initialized_sent.exchange(true)) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(data->frame_mutex);
+  flutter::EncodableValue res(flutter::EncodableMap{
+      {flutter::EncodableValue("event"),
+       flutter::EncodableValue("initialized")},
+      {flutter::EncodableValue("duration"),
+       flutter::EncodableValue(static_cast<int>(
+           data->duration > 0 ? data->duration / GST_MSECOND : 0))},
+      {flutter::EncodableValue("width"), flutter::EncodableValue(data->width)},
+      {flutter::EncodableValue("height"),
+       flutter::EncodableValue(data->height)},
+  });
+  lock.unlock();
+
+  auto& codec = flutter::StandardMethodCodec::GetInstance();
+  auto result = codec.EncodeSuccessEnvelope(&res);
+  std::stringstream ss_event_name;
+  ss_event_name << kChannelGstreamerEventPrefix << data->id;
+  auto event_name = ss_event_name.str();
+  FML_DLOG(INFO) << "send event initialized " << event_name;
+  data->engine->SendPlatformMessage(event_name.c_str(), result->data(),
+                                    result->size());
+}
+
+// Periodic `stats` event, runs on the player main loop.
+static gboolean send_stats_event(gpointer user_data) {
+  auto data = static_cast<CustomData*>(user_data);
+  if (!data->events_enabled) {
+    return G_SOURCE_CONTINUE;
+  }
+  auto map = data->stats.ToEncodable();
+  map[flutter::EncodableValue("event")] = flutter::EncodableValue("stats");
+  flutter::EncodableValue res(map);
+  auto& codec = flutter::StandardMethodCodec::GetInstance();
+  auto result = codec.EncodeSuccessEnvelope(&res);
+  std::stringstream ss_event_name;
+  ss_event_name << kChannelGstreamerEventPrefix << data->id;
+  auto event_name = ss_event_name.str();
+  data->engine->SendPlatformMessage(event_name.c_str(), result->data(),
+                                    result->size());
+  return G_SOURCE_CONTINUE;
+}
+
+static void set_stats_interval(CustomData* data, int32_t interval_ms) {
+  if (data->stats_source) {
+    g_source_destroy(data->stats_source);
+    g_source_unref(data->stats_source);
+    data->stats_source = nullptr;
+  }
+  if (interval_ms <= 0 || data->context == nullptr) {
+    return;
+  }
+  data->stats_source = g_timeout_source_new(interval_ms);
+  g_source_set_callback(data->stats_source, send_stats_event, data, nullptr);
+  g_source_attach(data->stats_source, data->context);
+}
+
+// GSTREAMER_POSITION_INTERVAL_MS=<ms> starts every player in push mode;
+// the `positionUpdates` method sets it per player.
+static int32_t default_position_interval() {
+  static const int32_t interval_ms = [] {
+    const char* env = getenv("GSTREAMER_POSITION_INTERVAL_MS");
+    int val = env ? atoi(env) : 0;
+    return val > 0 ? val : 0;
+  }();
+  return interval_ms;
+}
+
+static void send_event(CustomData* data, const flutter::EncodableValue& event) {
+  if (data->id == 0) {
+    return;
+  }
+  auto& codec = flutter::StandardMethodCodec::GetInstance();
+  auto result = codec.EncodeSuccessEnvelope(&event);
+  std::stringstream ss_event_name;
+  ss_event_name << kChannelGstreamerEventPrefix << data->id;
+  auto event_name = ss_event_name.str();
+  data->engine->SendPlatformMessage(event_name.c_str(), result->data(),
+                                    result->size());
+}
+
+// Error envelope on the event channel, the player fails to initialize.
+static void send_error_event(CustomData* data, const char* message) {
+  if (data->id == 0 || !data->events_enabled) {
+    return;
+  }
+  auto& codec = flutter::StandardMethodCodec::GetInstance();
+  auto result = codec.EncodeErrorEnvelope("VideoError", message);
+  std::stringstream ss_event_name;
+  ss_event_name << kChannelGstreamerEventPrefix << data->id;
+  auto event_name = ss_event_name.str();
+  data->engine->SendPlatformMessage(event_name.c_str(), result->data(),
+                                    result->size());
+}
+
+// Buffered ranges in ms.  Elements answer the buffering query in percent
+// of the stream, so ranges are scaled by the duration.
+static std::vector<std::pair<int64_t, int64_t>> query_buffered(
+    CustomData* data) {
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  if (data->duration <= 0) {
+    return ranges;
+  }
+  GstQuery* query = gst_query_new_buffering(GST_FORMAT_PERCENT);
+  if (gst_element_query(data->playbin, query)) {
+    int64_t duration_ms = data->duration / GST_MSECOND;
+    guint n_ranges = gst_query_get_n_buffering_ranges(query);
+    for (guint i = 0; i < n_ranges; i++) {
+      gint64 start, stop;
+      if (gst_query_parse_nth_buffering_range(query, i, &start, &stop)) {
+        ranges.emplace_back(start * duration_ms / GST_FORMAT_PERCENT_MAX,
+                            stop * duration_ms / GST_FORMAT_PERCENT_MAX);
+      }
+    }
+  }
+  gst_query_unref(query);
+  return ranges;
+}
+
+// Periodic position publish, runs on the player main loop.  Keeps the
+// encoded OnPosition reply current and pushes `position` events, plus
+// `bufferingUpdate` when the buffered ranges change.
+static gboolean publish_position(gpointer user_data) {
+  auto data = static_cast<CustomData*>(user_data);
+  if (!data->initialized || data->id == 0) {
+    return G_SOURCE_CONTINUE;
+  }
+  gint64 position;
+  if (!gst_element_query_position(data->playbin, GST_FORMAT_TIME,
+                                  &position)) {
+    return G_SOURCE_CONTINUE;
+  }
+  auto position_ms = static_cast<int64_t>(position / GST_MSECOND);
+  auto textureId = static_cast<int32_t>(data->id);
+
+  flutter::EncodableValue reply(flutter::EncodableMap{
+      {flutter::EncodableValue("result"),
+       flutter::EncodableValue(flutter::EncodableMap{
+           {flutter::EncodableValue("textureId"),
+            flutter::EncodableValue(textureId)},
+           {flutter::EncodableValue("position"),
+            flutter::EncodableValue(position_ms)},
+       })},
+      {flutter::EncodableValue("error"), flutter::EncodableValue()},
+  });
+  auto encoded =
+      flutter::StandardMessageCodec::GetInstance().EncodeMessage(reply);
+  auto buffered = query_buffered(data);
+  bool buffered_changed;
+  {
+    std::lock_guard<std::mutex> lock(data->position_mutex);
+    // set_position_interval() replaced or stopped this source while the
+    // position was queried; polled mode must not serve a stale reply
+    if (data->position_source != g_main_current_source()) {
+      return G_SOURCE_REMOVE;
+    }
+    data->position = position;
+    data->position_reply = std::move(*encoded);
+    buffered_changed = buffered != data->buffered;
+    if (buffered_changed) {
+      data->buffered = buffered;
+    }
+  }
+
+  if (!data->events_enabled) {
+    return G_SOURCE_CONTINUE;
+  }
+  send_event(data, flutter::EncodableValue(flutter::EncodableMap{
+                       {flutter::EncodableValue("event"),
+                        flutter::EncodableValue("position")},
+                       {flutter::EncodableValue("position"),
+                        flutter::EncodableValue(position_ms)},
+                   }));
+  if (buffered_changed) {
+    flutter::EncodableList values;
+    for (const auto& [start, end] : buffered) {
+      values.emplace_back(flutter::EncodableList{
+          flutter::EncodableValue(start), flutter::EncodableValue(end)});
+    }
+    send_event(data, flutter::EncodableValue(flutter::EncodableMap{
+                         {flutter::EncodableValue("event"),
+                          flutter::EncodableValue("bufferingUpdate")},
+                         {flutter::EncodableValue("values"),
+                          flutter::EncodableValue(std::move(values))},
+                     }));
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+// 0 returns the player to polled mode, where OnPosition queries the
+// pipeline on every call.
+static void set_position_interval(CustomData* data, int32_t interval_ms) {
+  std::lock_guard<std::mutex> lock(data->position_mutex);
+  if (data->position_source) {
+    g_source_destroy(data->position_source);
+    g_source_unref(data->position_source);
+    data->position_source = nullptr;
+  }
+  data->position_reply.clear();
+  data->buffered.clear();
+  if (interval_ms <= 0 || data->context == nullptr) {
+    return;
+  }
+  data->position_source = g_timeout_source_new(interval_ms);
+  g_source_set_callback(data->position_source, publish_position, data,
+                        nullptr);
+  g_source_attach(data->position_source, data->context);
+}
+
+// Reports the output texture and the current planes to the engine's
+// texture memory accounting.
+static void track_allocations(CustomData* data) {
+  data->texture->ReleaseAllocations();
+  if (data->gl_ready) {
+    data->texture->TrackAllocation(
+        GL_RGB, output_width(data, data->applied_shift),
+        output_height(data, data->applied_shift));
+  }
+  if (data->shader) {
+    for (size_t i = 0; i < data->shader->n_planes; i++) {
+      const yuv::Plane& plane = data->shader->planes[i];
+      data->texture->TrackAllocation(plane.internal_format, plane.width,
+                                     plane.height);
+    }
+  }
+}
+
+// Vertex array, framebuffer and the shared geometry reference live as long
+// as the player context, across the streams of a pooled player.
+static void setup_context(CustomData* data) {
+  glGenVertexArrays(1, &data->vertex_arr_id);
+  glGenFramebuffers(1, &data->framebuffer);
+  if (!acquire_gl_resources()) {
+    FML_LOG(ERROR) << "Failed to create the shared quad geometry";
+  }
+  data->context_ready = true;
+}
+
+// Allocates the output texture at the output size.  Runs on the render
+// worker with the producer context current and frame_mutex held.  The GL
+// name is created here, so players without video never get one.
+static void setup_gl(CustomData* data) {
+  GLuint textureId = data->texture->GetTextureId();
+  if (textureId == 0) {
+    glGenTextures(1, &textureId);
+    data->texture->SetName(textureId);
+  }
+
+  data->applied_shift = data->output_shift;
+  gint width = output_width(data, data->applied_shift);
+  gint height = output_height(data, data->applied_shift);
+
+  if (!data->context_ready) {
+    setup_context(data);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, textureId);
+
+  gint size = width * height * 3;
+  auto buffer = new unsigned char[size]{0};
+
+  // immutable single level storage, frames are scaled to it on the GPU
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, width, height);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB,
+                  GL_UNSIGNED_BYTE, buffer);
+  delete[] buffer;
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  yuv::AttachFramebuffer(data->framebuffer, textureId);
+
+  setup_render_state(data);
+  data->gl_ready = true;
+  track_allocations(data);
+}
+
+// (Re)creates the plane textures when the frame format, size or colorimetry
+// changes.  Runs with the producer context current and frame_mutex held.
+static bool update_shader(CustomData* data, const GstVideoInfo* info) {
+  yuv::Format format;
+  if (!yuv::FromVideoFormat(GST_VIDEO_INFO_FORMAT(info), &format)) {
+    FML_LOG(ERROR) << "Unsupported frame format "
+                   << gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(info));
+    return false;
+  }
+  if (data->shader && data->shader->Matches(format, info)) {
+    return true;
+  }
+  GLuint program = get_program(format);
+  if (program == 0) {
+    FML_LOG(ERROR) << "Failed to build the "
+                   << gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(info))
+                   << " program";
+    return false;
+  }
+  delete data->shader;
+  data->shader = new yuv::Shader(program, format, info);
+  data->shader->Bind();
+  FML_DLOG(INFO) << "frames " << info->width << "x" << info->height << " "
+                 << gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(info))
+                 << ", output " << output_width(data, data->applied_shift)
+                 << "x" << output_height(data, data->applied_shift);
+  track_allocations(data);
+  return true;
+}
+
+// Runs on the player's render worker, which keeps the producer context
+// current for its whole lifetime.  Planes are uploaded as decoded, the
+// conversion and scaling happen in the fragment shader.
+// Returns true if the sample is now in the texture.
+bool render_buffer(CustomData* data, GstSample* sample) {
+  GstVideoFrame frame;
+  GstCaps* caps = gst_sample_get_caps(sample);
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+
+  if (!data->initialized || caps == nullptr || buffer == nullptr) {
+    return false;
+  }
+
+  // the texture is swapped while a pooled player is parked
+  std::lock_guard<std::mutex> lock(data->frame_mutex);
+  if (data->texture == nullptr || buffer == data->last_buffer) {
+    return false;
+  }
+  int64_t textureId = data->id;
+  // caps are shared by every sample of a negotiation
+  if (caps != data->frame_caps) {
+    if (!gst_video_info_from_caps(&data->frame_info, caps)) {
+      FML_DLOG(ERROR) << "Fail to get video info from the sample caps";
+      return false;
+    }
+    if (data->frame_caps) {
+      gst_caps_unref(data->frame_caps);
+    }
+    data->frame_caps = gst_caps_ref(caps);
+  }
+
+  if (gst_video_frame_map(&frame, &data->frame_info, buffer, GST_MAP_READ)) {
+    if (!data->engine->GetEglWindow()->MakeProducerCurrent(
+            data->egl_context)) {
+      gst_video_frame_unmap(&frame);
+      return false;
+    }
+    // The output size changed under memory pressure.  The new texture
+    // replaces the old one on the framebuffer; the old one is deleted once
+    // the engine has been given the new name.
+    GLuint replaced = 0;
+    if (data->gl_ready && data->applied_shift != data->output_shift) {
+      replaced = data->texture->GetTextureId();
+      data->texture->SetName(0);
+      data->gl_ready = false;
+    }
+    if (!data->gl_ready) {
+      setup_gl(data);
+    }
+    if (!update_shader(data, &data->frame_info)) {
+      gst_video_frame_unmap(&frame);
+      if (replaced) {
+        glDeleteTextures(1, &replaced);
+      }
+      return false;
+    }
+    int64_t render_start = stream_stats_period() ? thread_cpu_ns() : 0;
+
+    auto upload_start = std::chrono::steady_clock::now();
+    data->shader->LoadFrame(&frame);
+    gst_video_frame_unmap(&frame);
+
+    auto convert_start = std::chrono::steady_clock::now();
+    draw_core();
+    auto convert_end = std::chrono::steady_clock::now();
+    data->texture->FrameReady();
+    gst_buffer_replace(&data->last_buffer, buffer);
+    if (replaced) {
+      glDeleteTextures(1, &replaced);
+    }
+
+    data->stats.upload.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               convert_start - upload_start)
+                               .count());
+    data->stats.convert.Add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(convert_end -
+                                                             convert_start)
+            .count());
+    data->stats.frames_rendered++;
+
+    if (render_start) {
+      update_stream_stats(data, textureId, thread_cpu_ns() - render_start);
+    }
+    return true;
+  }
+  FML_DLOG(ERROR) << "Cannot read video frame out from buffer";
+  return false;
+}
+
+// appsink streaming thread: only wakes the render worker, so decoding is
+// never blocked on GL
+static GstFlowReturn on_new_sample(GstAppSink* appsink, gpointer user_data) {
+  auto data = static_cast<CustomData*>(user_data);
+  data->stats.frames_decoded++;
+  {
+    std::lock_guard<std::mutex> lock(data->render_mutex);
+    data->render_pending = true;
+  }
+  data->render_cv.notify_one();
+  return GST_FLOW_OK;
+}
+
+// appsink streaming thread: a preroll buffer is held after reaching PAUSED
+// and after every paused seek; the render worker shows it.
+static GstFlowReturn on_new_preroll(GstAppSink* appsink, gpointer user_data) {
+  auto data = static_cast<CustomData*>(user_data);
+  {
+    std::lock_guard<std::mutex> lock(data->render_mutex);
+    data->preroll_pending = true;
+  }
+  data->render_cv.notify_one();
+  return GST_FLOW_OK;
+}
+
+// How far the pipeline clock is past the frame's running time.  The clock
+// is normally provided by the audio sink.  Returns false without a clock
+// or timestamp.
+static bool clock_delay(CustomData* data,
+                        GstSample* sample,
+                        GstBuffer* buffer,
+                        int64_t* delay) {
+  const GstSegment* segment = gst_sample_get_segment(sample);
+  if (segment == nullptr || !GST_BUFFER_PTS_IS_VALID(buffer)) {
+    return false;
+  }
+  GstClock* clock = gst_element_get_clock(data->playbin);
+  if (clock == nullptr) {
+    return false;
+  }
+  GstClockTime now = gst_clock_get_time(clock);
+  gst_object_unref(clock);
+  GstClockTime base_time = gst_element_get_base_time(data->playbin);
+  guint64 running_time = gst_segment_to_running_time(
+      segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+  if (!GST_CLOCK_TIME_IS_VALID(running_time) || now < base_time) {
+    return false;
+  }
+  *delay =
+      static_cast<int64_t>(now - base_time) - static_cast<int64_t>(running_time);
+  return true;
+}
+
+// A/V drift, taken as the frame reaches the render worker.
+static void update_av_drift(CustomData* data,
+                            GstSample* sample,
+                            GstBuffer* buffer) {
+  int64_t drift;
+  if (clock_delay(data, sample, buffer, &drift)) {
+    data->stats.SetDrift(drift);
+  }
+}
+
+// Live sources timestamp buffers at capture, so once the frame is in the
+// texture and its frame available notification is queued this is capture
+// to texture publish, upload and conversion included.
+static void update_latency(CustomData* data,
+                           GstSample* sample,
+                           GstBuffer* buffer) {
+  int64_t latency;
+  if (data->is_live && clock_delay(data, sample, buffer, &latency)) {
+    data->stats.latency.Add(latency);
+  }
+}
+
+// Publishes a sample to the texture and tracks what is on screen.
+static void present_sample(CustomData* data, GstSample* sample, bool playing) {
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  if (buffer == nullptr) {
+    return;
+  }
+  if (playing) {
+    update_av_drift(data, sample, buffer);
+  }
+  if (!render_buffer(data, sample)) {
+    return;
+  }
+  if (playing) {
+    update_latency(data, sample, buffer);
+  }
+  const GstSegment* segment = gst_sample_get_segment(sample);
+  if (segment && GST_BUFFER_PTS_IS_VALID(buffer)) {
+    guint64 stream_time = gst_segment_to_stream_time(
+        segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    if (GST_CLOCK_TIME_IS_VALID(stream_time)) {
+      data->frame_position = static_cast<gint64>(stream_time);
+    }
+  }
+  if (!data->first_frame.exchange(true)) {
+    data->stats.first_frame_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - data->create_time)
+            .count();
+    FML_DLOG(INFO) << "first frame after "
+                   << data->stats.first_frame_ns / 1000 << " us";
+    send_initialized_event(data);
+  }
+}
+
+// The engine clock.  FlutterEngineGetCurrentTime() and the surface frame
+// times are CLOCK_MONOTONIC, as is steady_clock.
+static int64_t engine_time_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Engine time at which a sample is due on screen, or -1 while the
+// pipeline clock is not running.
+static int64_t due_time(CustomData* data, GstSample* sample) {
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  const GstSegment* segment = gst_sample_get_segment(sample);
+  if (buffer == nullptr || segment == nullptr ||
+      !GST_BUFFER_PTS_IS_VALID(buffer)) {
+    return engine_time_ns();
+  }
+  if (GST_STATE(data->playbin) != GST_STATE_PLAYING) {
+    return -1;
+  }
+  GstClock* clock = gst_element_get_clock(data->playbin);
+  if (clock == nullptr) {
+    return -1;
+  }
+  guint64 running_time = gst_segment_to_running_time(
+      segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+  if (!GST_CLOCK_TIME_IS_VALID(running_time)) {
+    gst_object_unref(clock);
+    return engine_time_ns();
+  }
+  GstClockTime latency = 0;
+#if GST_CHECK_VERSION(1, 6, 0)
+  latency = gst_pipeline_get_latency(GST_PIPELINE(data->playbin));
+  if (!GST_CLOCK_TIME_IS_VALID(latency)) {
+    latency = 0;
+  }
+#endif
+  auto clock_due = static_cast<int64_t>(
+      gst_element_get_base_time(data->playbin) + running_time + latency);
+  auto clock_now = static_cast<int64_t>(gst_clock_get_time(clock));
+  int64_t now = engine_time_ns();
+  gst_object_unref(clock);
+  return now + (clock_due - clock_now);
+}
+
+// Immediate presentation: the appsink syncs on the clock and the newest
+// sample is shown as soon as it arrives.
+static void present_immediate(CustomData* data, bool preroll) {
+  auto appsink = GST_APP_SINK(data->sink);
+  // keep only the newest queued sample, older ones are already late
+  GstSample* sample = nullptr;
+  uint32_t depth = 0;
+  while (GstSample* next = gst_app_sink_try_pull_sample(appsink, 0)) {
+    if (sample) {
+      gst_sample_unref(sample);
+    }
+    sample = next;
+    depth++;
+  }
+  if (depth) {
+    data->stats.SetQueueDepth(depth);
+  }
+#if GST_CHECK_VERSION(1, 10, 0)
+  // not playing, the frame on screen is the preroll buffer
+  if (!sample && preroll) {
+    sample = gst_app_sink_try_pull_preroll(appsink, 0);
+  }
+#endif
+  if (sample) {
+    present_sample(data, sample, depth != 0);
+    gst_sample_unref(sample);
+  }
+}
+
+// Scheduled presentation, see vsync_presentation().  Samples are pulled
+// ahead of their PTS; each display frame publishes the newest sample due
+// by then, samples overtaken before their display frame are dropped
+// without being uploaded.
+class FrameScheduler {
+ public:
+  explicit FrameScheduler(CustomData* data) : m_data(data) {}
+  ~FrameScheduler() { Flush(); }
+
+  // Engine time the worker waits for, or 0 to wait for a new sample.
+  [[nodiscard]] int64_t WakeTime() const {
+    return m_next ? m_publish_at : m_wake_at;
+  }
+
+  void Flush() {
+    if (m_next) {
+      gst_sample_unref(m_next);
+      m_next = nullptr;
+    }
+    for (auto sample : m_queued) {
+      gst_sample_unref(sample);
+    }
+    m_queued.clear();
+    m_wake_at = 0;
+  }
+
+  void Run() {
+    auto appsink = GST_APP_SINK(m_data->sink);
+    while (m_queued.size() < kScheduledFrames) {
+      GstSample* sample = gst_app_sink_try_pull_sample(appsink, 0);
+      if (sample == nullptr) {
+        break;
+      }
+      m_queued.push_back(sample);
+    }
+    m_data->stats.SetQueueDepth(static_cast<uint32_t>(m_queued.size()));
+
+    int64_t now = engine_time_ns();
+    if (m_next && now >= m_publish_at) {
+      present_sample(m_data, m_next, true);
+      gst_sample_unref(m_next);
+      m_next = nullptr;
+    }
+    if (m_next || m_queued.empty()) {
+      m_wake_at = 0;
+      return;
+    }
+
+    auto window = m_data->engine->GetEglWindow();
+    int64_t interval = window->GetFrameInterval();
+    int64_t vsync = now;
+    int64_t last_vsync = window->GetLastFrameTime();
+    if (last_vsync > 0 && last_vsync <= now) {
+      vsync = last_vsync + ((now - last_vsync) / interval + 1) * interval;
+    }
+    while (!m_queued.empty()) {
+      int64_t due = due_time(m_data, m_queued.front());
+      if (due < 0 || due > vsync) {
+        // recheck once it falls within a display frame, at most a few
+        // times per frame
+        m_wake_at = due < 0 ? now + interval
+                            : std::max(due - interval, now + interval / 4);
+        break;
+      }
+      if (m_next) {
+        gst_sample_unref(m_next);
+      }
+      m_next = m_queued.front();
+      m_queued.pop_front();
+    }
+    if (m_next) {
+      // publish ahead of the display frame, so it is latched for it
+      m_publish_at = vsync - interval / 4;
+    }
+  }
+
+ private:
+  // samples held by the scheduler, on top of the appsink queue
+  static constexpr size_t kScheduledFrames = 3;
+
+  CustomData* m_data;
+  std::deque<GstSample*> m_queued;
+  GstSample* m_next{};
+  int64_t m_publish_at{};
+  int64_t m_wake_at{};
+};
+
+// Detaches the output textures of disposed streams from the player's
+// framebuffer and deletes them.  GL keeps attached storage alive, so a
+// parked player would otherwise hold its last output texture.  Runs on the
+// render worker.
+static void drop_output_textures(CustomData* data,
+                                 std::vector<GLuint>* names) {
+  if (names->empty()) {
+    return;
+  }
+  if (data->engine->GetEglWindow()->MakeProducerCurrent(data->egl_context)) {
+    glBindFramebuffer(GL_FRAMEBUFFER, data->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           0, 0);
+    glDeleteTextures(static_cast<GLsizei>(names->size()), names->data());
+  }
+  names->clear();
+}
+
+static void render_worker(CustomData* data) {
+  auto appsink = GST_APP_SINK(data->sink);
+  FrameScheduler scheduler(data);
+  std::vector<GLuint> stale;
+  while (true) {
+    bool preroll;
+    {
+      std::unique_lock<std::mutex> lock(data->render_mutex);
+      auto ready = [data] {
+        return data->render_pending || data->preroll_pending ||
+               data->render_stop || !data->stale_textures.empty();
+      };
+      int64_t wake_at = data->scheduled ? scheduler.WakeTime() : 0;
+      if (wake_at > 0) {
+        data->render_cv.wait_until(
+            lock,
+            std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(wake_at)),
+            ready);
+      } else {
+        data->render_cv.wait(lock, ready);
+      }
+      stale.swap(data->stale_textures);
+      if (data->render_stop) {
+        break;
+      }
+      preroll = data->preroll_pending;
+      data->render_pending = false;
+      data->preroll_pending = false;
+    }
+    drop_output_textures(data, &stale);
+
+    if (!data->scheduled) {
+      present_immediate(data, preroll);
+      continue;
+    }
+#if GST_CHECK_VERSION(1, 10, 0)
+    // after a flush the preroll buffer replaces everything scheduled
+    if (preroll) {
+      if (GstSample* sample = gst_app_sink_try_pull_preroll(appsink, 0)) {
+        scheduler.Flush();
+        present_sample(data, sample, false);
+        gst_sample_unref(sample);
+      }
+    }
+#endif
+    scheduler.Run();
+  }
+  drop_output_textures(data, &stale);
+  scheduler.Flush();
+  {
+    std::lock_guard<std::mutex> lock(data->frame_mutex);
+    gst_buffer_replace(&data->last_buffer, nullptr);
+  }
+  if (data->frame_caps) {
+    gst_caps_unref(data->frame_caps);
+    data->frame_caps = nullptr;
+  }
+  data->engine->GetEglWindow()->ClearCurrent();
+}
+
+static void stop_render_worker(CustomData* data) {
+  if (!data->render_thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(data->render_mutex);
+    data->render_stop = true;
+  }
+  data->render_cv.notify_one();
+  data->render_thread.join();
+}
+
+// Producer context and render worker, started once the stream turns out
+// to have video.  Both stay with a pooled player for its next streams.
+// Returns false if no producer context could be created.
+static bool start_video(CustomData* data) {
+  if (data->render_thread.joinable()) {
+    return true;
+  }
+  if (data->egl_context == EGL_NO_CONTEXT) {
+    data->egl_context = data->engine->GetEglWindow()->CreateProducerContext();
+    if (data->egl_context == EGL_NO_CONTEXT) {
+      return false;
+    }
+  }
+  data->render_thread = std::thread{render_worker, data};
+  return true;
+}
+
+// Audio-only media has no frame to wait for; `initialized` goes out with
+// a 0x0 size once the pipeline prerolled.
+static void prepare_audio(CustomData* data) {
+  FML_DLOG(INFO) << "no video stream, audio only";
+  {
+    std::lock_guard<std::mutex> lock(data->frame_mutex);
+    data->width = 0;
+    data->height = 0;
+  }
+  if (!gst_element_query_duration(data->playbin, GST_FORMAT_TIME,
+                                  &data->duration)) {
+    data->duration = 0;
+  }
+  data->first_frame = true;
+  data->initialized = true;
+  send_initialized_event(data);
+  if (default_position_interval() > 0) {
+    set_position_interval(data, default_position_interval());
+  }
+}
+
+static void prepare(CustomData* data) {
+  GstElement* playbin = data->playbin;
+  if (data->audio_only) {
+    prepare_audio(data);
+    return;
+  }
+  g_object_get(playbin, "n-video", &(data->n_video), nullptr);
+  FML_DLOG(INFO) << data->n_video << " video streams";
+  g_object_get(playbin, "current-video", &(data->current_video), nullptr);
+  GstPad* pad = nullptr;
+  g_signal_emit_by_name(playbin, "get-video-pad", data->current_video, &pad);
+  if (!pad && data->n_video == 0) {
+    prepare_audio(data);
+    return;
+  }
+  if (!pad) {
+    FML_DLOG(INFO) << "Failed to get video pad, stream number might not exist";
+    g_main_loop_quit(data->main_loop);
+    return;
+  }
+  GstCaps* caps = gst_pad_get_current_caps(pad);
+  gst_object_unref(pad);
+  assert(caps);
+  {
+    std::lock_guard<std::mutex> lock(data->frame_mutex);
+    gboolean ret = gst_video_info_from_caps(&data->info, caps);
+    gst_caps_unref(caps);
+    if (!ret) {
+      FML_DLOG(ERROR) << "Fail to get video info from the cap";
+      g_main_loop_quit(data->main_loop);
+      return;
+    }
+    FML_DLOG(INFO) << "original video width: " << data->info.width
+                   << ", height: " << data->info.height;
+    // without a requested size the stream is rendered at its own size
+    if (data->width <= 0 || data->height <= 0) {
+      data->width = data->info.width;
+      data->height = data->info.height;
+    }
+  }
+  if (!gst_element_query_duration(playbin, GST_FORMAT_TIME,
+                                  &data->duration)) {
+    data->duration = 0;
+  }
+  if (!start_video(data)) {
+    FML_LOG(ERROR) << "(" << data->id << ") no producer context";
+    send_error_event(data, "Failed to create the producer context");
+    g_main_loop_quit(data->main_loop);
+    return;
+  }
+  data->initialized = true;
+  // the preroll buffer arrived before the stream info, show it now
+  {
+    std::lock_guard<std::mutex> lock(data->render_mutex);
+    data->preroll_pending = true;
+  }
+  data->render_cv.notify_one();
+  if (default_position_interval() > 0) {
+    set_position_interval(data, default_position_interval());
+  }
+}
+
+// Rate changes keep the buffered data.  An instant rate change (1.18)
+// applies to the running segment without a seek; otherwise a non-flushing
+// seek continues from where the demuxer is.  Only a direction change
+// flushes, from the position of the frame on screen.
+static bool change_rate(CustomData* data, gdouble rate) {
+  gdouble current = data->rate != 0.0 ? data->rate : 1.0;
+  bool same_direction = (rate > 0) == (current > 0);
+#if GST_CHECK_VERSION(1, 18, 0)
+  if (same_direction &&
+      gst_element_seek(data->playbin, rate, GST_FORMAT_TIME,
+                       GST_SEEK_FLAG_INSTANT_RATE_CHANGE, GST_SEEK_TYPE_NONE,
+                       0, GST_SEEK_TYPE_NONE, 0)) {
+    return true;
+  }
+#endif
+  if (same_direction) {
+    return gst_element_seek(data->playbin, rate, GST_FORMAT_TIME,
+                            GST_SEEK_FLAG_NONE, GST_SEEK_TYPE_NONE, 0,
+                            GST_SEEK_TYPE_NONE, 0);
+  }
+
+  gint64 position = data->frame_position;
+  if (position < 0 && !gst_element_query_position(
+                          data->playbin, GST_FORMAT_TIME, &position)) {
+    FML_LOG(ERROR) << "Unable to retrieve current position";
+    return false;
+  }
+  auto flags = (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
+  if (rate > 0) {
+    return gst_element_seek(data->playbin, rate, GST_FORMAT_TIME, flags,
+                            GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_END, 0);
+  }
+  return gst_element_seek(data->playbin, rate, GST_FORMAT_TIME, flags,
+                          GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, position);
+}
+
+// Download buffers live next to the engine cache; queue2 removes them.
+static std::string download_template() {
+  static const std::string path = paths::JoinPaths(
+      {Engine::GetPersistentCachePath(), "gstreamer-download-XXXXXX"});
+  return path;
+}
 
-  if (avformat_open_input(&fmt_ctx, url, nullptr, nullptr) < 0) {
-    FML_LOG(ERROR) << "Unable to open: " << url;
-    avformat_free_context(fmt_ctx);
-    return false;
+// Applies the player's buffering profile, playbin must be at most READY.
+static void apply_buffering(CustomData* data) {
+  const buffering::Profile* profile = data->buffering.profile;
+  gint flags = 0;
+  g_object_get(data->playbin, "flags", &flags, nullptr);
+  if (profile->download) {
+    flags |= GST_PLAY_FLAG_DOWNLOAD;
+  } else {
+    flags &= ~GST_PLAY_FLAG_DOWNLOAD;
   }
+  g_object_set(data->playbin, "flags", flags, "buffer-size",
+               profile->buffer_size, "buffer-duration",
+               profile->buffer_duration, "ring-buffer-max-size",
+               profile->ring_buffer_max_size, "connection-speed",
+               profile->connection_speed, nullptr);
+  data->prefetched = profile->prefetch <= 0;
+  FML_DLOG(INFO) << "buffering profile " << profile->name;
+}
 
-  if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
-    FML_LOG(ERROR) << "Cannot find stream information: " << url;
-    avformat_free_context(fmt_ctx);
-    return false;
+// The prefetch is in once the buffered range at the current position
+// reaches `prefetch` ahead, or the end of the stream.
+static bool prefetch_done(CustomData* data) {
+  if (data->prefetched) {
+    return true;
   }
-
-#if defined(AVFORMAT_WITH_CONST)
-  const AVCodec* dec = nullptr;
-#else
-  AVCodec* dec;
-#endif
-  int ret = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &dec, 0);
-  if (ret < 0) {
-    FML_DLOG(ERROR) << "Cannot find a video stream in the input file";
-    avformat_free_context(fmt_ctx);
+  if (data->duration <= 0) {
     return false;
   }
-  int video_stream_index = ret;
-  AVStream* stream = fmt_ctx->streams[video_stream_index];
-  AVCodecParameters* par = stream->codecpar;
-
-  codec_id = par->codec_id;
-  width = par->width;
-  height = par->height;
-  duration = fmt_ctx->duration;
-
-#if GSTREAMER_DEBUG
-  av_dump_format(fmt_ctx, 0, url, 0);
-#endif
-
-  avformat_free_context(fmt_ctx);
-  return true;
+  int64_t from_ms = std::max<gint64>(data->frame_position, 0) / GST_MSECOND;
+  int64_t to_ms =
+      std::min(data->duration,
+               std::max<gint64>(data->frame_position, 0) +
+                   data->buffering.profile->prefetch) /
+      GST_MSECOND;
+  for (const auto& [start, end] : query_buffered(data)) {
+    if (start <= from_ms && end >= to_ms) {
+      data->prefetched = true;
+      break;
+    }
+  }
+  return data->prefetched;
 }
 
-void loadRGBPixels(GLuint textureId,
-                   unsigned char* data,
-                   int width,
-                   int height) {
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, textureId);
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, data);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glGenerateMipmap(GL_TEXTURE_2D);
+static void end_buffering(CustomData* data) {
+  if (data->is_buffering) {
+    data->is_buffering = false;
+    send_event(data, flutter::EncodableValue(flutter::EncodableMap{
+                         {flutter::EncodableValue("event"),
+                          flutter::EncodableValue("bufferingEnd")},
+                     }));
+  }
+  // if the desired state is playing, go back
+  if (data->target_state == GST_STATE_PLAYING) {
+    gst_element_set_state(data->playbin, GST_STATE_PLAYING);
+  }
 }
 
-void draw_core(nv12::Shader* shader) {
-  glViewport(-shader->width / 2, -shader->height / 2, shader->width * 2,
-             shader->height * 2);
-  glClearColor(0, 0, 0, 0);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glUseProgram(shader->program);
-
-  glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-
-  glEnableVertexAttribArray(1);
-  glBindBuffer(GL_ARRAY_BUFFER, coordbuffer);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-
-  glDrawArrays(GL_TRIANGLES, 0, 6);
+static gboolean check_prefetch(gpointer user_data) {
+  auto data = static_cast<CustomData*>(user_data);
+  // a parked player stops waiting
+  bool parked = data->target_state == GST_STATE_READY;
+  if (!parked && !prefetch_done(data)) {
+    return G_SOURCE_CONTINUE;
+  }
+  if (!parked) {
+    end_buffering(data);
+  }
+  g_source_unref(data->prefetch_source);
+  data->prefetch_source = nullptr;
+  return G_SOURCE_REMOVE;
+}
 
-  glDisableVertexAttribArray(0);
-  glDisableVertexAttribArray(1);
+// queue2 may stop posting buffering messages at 100% while the prefetch
+// is still filling, so it is polled on the player main loop.
+static void watch_prefetch(CustomData* data) {
+  if (data->prefetch_source) {
+    return;
+  }
+  data->prefetch_source = g_timeout_source_new(250);
+  g_source_set_callback(data->prefetch_source, check_prefetch, data, nullptr);
+  g_source_attach(data->prefetch_source, data->context);
+}
 
-  glFinish();
+// Directory below the engine's persistent cache, created on first use.
+static std::string cache_dir(const char* name) {
+  auto path = paths::JoinPaths({Engine::GetPersistentCachePath(), name});
+  if (mkdir(path.c_str(), S_IRWXU) < 0 && errno != EEXIST) {
+    FML_LOG(ERROR) << "mkdir failed: " << path;
+  }
+  return path;
 }
 
-void handoff_handler(GstElement* fakesink,
-                     GstBuffer* buffer,
-                     GstPad* pad,
-                     gpointer _data) {
-  auto data = (CustomData*)_data;
-  assert(data->texture);
-  int64_t textureId = data->texture->GetTextureId();
+static std::string keyframe_cache_dir() {
+  static const std::string dir = cache_dir("keyframes");
+  return dir;
+}
 
-  GstVideoFrame frame;
-  GstVideoMeta* meta;
-  GstMapInfo map;
+static std::string thumbnail_cache_dir() {
+  static const std::string dir = cache_dir("thumbnails");
+  return dir;
+}
 
-  if (!data->initialized) {
-    return;
+// Issues the queued scrub seek; called with seek_mutex held.  Seeks land on
+// keyframes, so nothing is decoded past the target, and a target snapping
+// to the keyframe already on screen is dropped.
+static void issue_scrub_seek(CustomData* data) {
+  gint64 target = data->seek_target;
+  data->seek_target = -1;
+  if (data->keyframes && data->keyframes->Ready()) {
+    target = data->keyframes->Snap(target);
+    if (target == data->scrub_keyframe) {
+      return;
+    }
   }
-  if (data->info.finfo == nullptr) {
-    // skip
-    return;
+  if (gst_element_seek_simple(
+          data->playbin, GST_FORMAT_TIME,
+          (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+                         GST_SEEK_FLAG_SNAP_NEAREST),
+          target)) {
+    data->seek_in_flight = true;
+    data->seek_issued = std::chrono::steady_clock::now();
+    data->scrub_keyframe = target;
   }
+}
 
-  std::lock_guard<std::mutex> lock(gst_mutex);
-  if (gst_video_frame_map(&frame, &data->info, buffer, GST_MAP_READ)) {
-    data->engine->GetEglWindow()->MakeTextureCurrent();
-    glBindVertexArray(vertex_arr_id);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    size_t width = data->info.width;
-    size_t height = data->info.height;
-    guint n_planes = GST_VIDEO_INFO_N_PLANES(&data->info);
-    if (n_planes == 2) {
-      // Assume NV12
-      gpointer y_buf = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
-      guint y_stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
-      guint y_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, 0);
-      gpointer uv_buf = GST_VIDEO_FRAME_PLANE_DATA(&frame, 1);
-      guint uv_stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 1);
-      guint uv_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, 1);
-      data->shader->loadPixels((unsigned char*)y_buf, (unsigned char*)uv_buf,
-                               y_pixel_stride, y_stride, uv_pixel_stride,
-                               uv_stride);
-    } else {
-      // Assume RGB
-      gpointer video_frame_plane_buffer = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
-      loadRGBPixels(textureId, (unsigned char*)video_frame_plane_buffer,
-                    data->info.width, data->info.height);
-    }
-    gst_video_frame_unmap(&frame);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, data->shader->framebuffer);
-    draw_core(data->shader);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    draw_core(data->shader);
-    data->engine->GetEglWindow()->ClearCurrent();
-    data->texture->FrameReady();
-  } else {
-    FML_DLOG(ERROR) << "Cannot read video frame out from buffer";
+// Seeks while scrubbing collapse: one seek is in flight at a time and only
+// the latest request waits for it, the rest are dropped.  Returns false if
+// the player is not scrubbing.
+static bool scrub_seek(CustomData* data, gint64 position) {
+  std::lock_guard<std::mutex> lock(data->seek_mutex);
+  if (!data->scrubbing) {
+    return false;
   }
+  data->seek_target = position;
+  data->scrub_position = position;
+  if (!data->seek_in_flight || std::chrono::steady_clock::now() -
+                                       data->seek_issued >
+                                   kScrubSeekTimeout) {
+    issue_scrub_seek(data);
+  }
+  return true;
 }
 
-static void prepare(CustomData* data) {
-  GstElement* playbin = data->playbin;
-  g_object_get(playbin, "n-video", &(data->n_video), nullptr);
-  FML_DLOG(INFO) << data->n_video << " video streams";
-  g_object_get(playbin, "current-video", &(data->current_video), nullptr);
-  GstPad* pad = nullptr;
-  g_signal_emit_by_name(playbin, "get-video-pad", data->current_video, &pad);
-  if (!pad) {
-    FML_DLOG(INFO) << "Failed to get video pad, stream number might not exist";
-    g_main_loop_quit(data->main_loop);
+// Releasing the scrubber lands exactly on the last requested position.
+static void set_scrubbing(CustomData* data, bool scrubbing) {
+  std::lock_guard<std::mutex> lock(data->seek_mutex);
+  if (scrubbing == data->scrubbing) {
     return;
   }
-  GstCaps* caps = gst_pad_get_current_caps(pad);
-  assert(caps);
-  std::lock_guard<std::mutex> lock(gst_mutex);
-  if (!gst_video_info_from_caps(&data->info, caps)) {
-    FML_DLOG(ERROR) << "Fail to get video info from the cap";
-    g_main_loop_quit(data->main_loop);
+  data->scrubbing = scrubbing;
+  data->seek_target = -1;
+  data->scrub_keyframe = -1;
+  if (scrubbing) {
+    // every audio frame is a key frame
+    if (!data->keyframes && !data->audio_only) {
+      data->keyframes =
+          keyframe::Index::Get(data->uri, keyframe_cache_dir());
+    }
     return;
   }
-  FML_DLOG(INFO) << "original video width: " << data->info.width
-                 << ", height: " << data->info.height;
-  // set to the target
-  if (!gst_video_info_set_format(&data->info, GST_VIDEO_FORMAT_NV12,
-                                 data->width, data->height)) {
-    FML_DLOG(ERROR) << "Failed to set the video info to target NV12";
+  if (data->scrub_position >= 0 &&
+      !gst_element_seek_simple(
+          data->playbin, GST_FORMAT_TIME,
+          (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+          data->scrub_position)) {
+    FML_DLOG(ERROR) << "accurate seek to " << data->scrub_position
+                    << " failed";
   }
-  data->initialized = true;
+  data->scrub_position = -1;
 }
 
 static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
   GError* err;
   gchar* debug_info;
-  int64_t textureId =
-      data->texture == nullptr ? 0 : data->texture->GetTextureId();
+  int64_t textureId = data->id;
   switch (GST_MESSAGE_TYPE(msg)) {
     case GST_MESSAGE_ERROR:
       gst_message_parse_error(msg, &err, &debug_info);
@@ -296,6 +1564,9 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
                       << GST_OBJECT_NAME(msg->src) << ":" << err->message;
       FML_DLOG(ERROR) << "Debug information "
                       << (debug_info ? debug_info : "none");
+      if (!data->initialized) {
+        send_error_event(data, err->message);
+      }
       gst_object_unref(bus);
       g_clear_error(&err);
       g_free(debug_info);
@@ -333,10 +1604,12 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
       gst_message_parse_state_changed(msg, &old_state, &new_state,
                                       &pending_state);
       if (GST_MESSAGE_SRC(msg) == GST_OBJECT(data->playbin)) {
-        if (new_state == GST_STATE_PLAYING) {
+        if (new_state == GST_STATE_PAUSED && !data->initialized) {
+          FML_DLOG(INFO) << "message state changed, prerolled " << textureId;
+          prepare(data);
+        } else if (new_state == GST_STATE_PLAYING) {
           FML_DLOG(INFO) << "message state changed, start playing "
                          << textureId;
-          prepare(data);
         } else if (new_state == GST_STATE_READY) {
           FML_DLOG(INFO) << "message state changed, ready " << textureId;
         }
@@ -359,6 +1632,17 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
       break;
     }
 #endif
+    case GST_MESSAGE_QOS: {
+      if (GST_MESSAGE_SRC(msg) == GST_OBJECT(data->sink)) {
+        GstFormat format;
+        guint64 processed, dropped;
+        gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+        if (format == GST_FORMAT_BUFFERS) {
+          data->stats.frames_late = dropped;
+        }
+      }
+      break;
+    }
     case GST_MESSAGE_LATENCY: {
       FML_DLOG(INFO) << "Latency";
       break;
@@ -369,6 +1653,12 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
     }
     case GST_MESSAGE_ASYNC_DONE: {
       FML_DLOG(INFO) << "Async Done";
+      // the previous scrub seek is on screen, run the latest queued one
+      std::lock_guard<std::mutex> lock(data->seek_mutex);
+      data->seek_in_flight = false;
+      if (data->scrubbing && data->seek_target >= 0) {
+        issue_scrub_seek(data);
+      }
       // bufferingEnd
       break;
     }
@@ -388,27 +1678,12 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
       gst_message_parse_buffering(msg, &percent);
       // FML_DLOG(INFO) << "Buffering: " << percent << "%";
 
-      // TODO - bufferingUpdate
-
       if (percent == 100) {
-        // a 100% message means buffering is done
-        if (data->is_buffering) {
-          data->is_buffering = false;
-          flutter::EncodableValue res(flutter::EncodableMap{
-              {flutter::EncodableValue("event"),
-               flutter::EncodableValue("bufferingEnd")},
-          });
-          auto& codec = flutter::StandardMethodCodec::GetInstance();
-          auto result = codec.EncodeSuccessEnvelope(&res);
-          std::stringstream ss_event_name;
-          ss_event_name << kChannelGstreamerEventPrefix << data->texture;
-          auto event_name = ss_event_name.str();
-          data->engine->SendPlatformMessage(event_name.c_str(), result->data(),
-                                            result->size());
-        }
-        // if the desired state is playing, go back
-        if (data->target_state == GST_STATE_PLAYING) {
-          gst_element_set_state(data->playbin, GST_STATE_PLAYING);
+        // a 100% message means buffering is done, once the prefetch is in
+        if (prefetch_done(data)) {
+          end_buffering(data);
+        } else {
+          watch_prefetch(data);
         }
       } else {
         // buffering busy
@@ -418,17 +1693,10 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
         }
         if (!data->is_buffering) {
           data->is_buffering = true;
-          flutter::EncodableValue res(flutter::EncodableMap{
-              {flutter::EncodableValue("event"),
-               flutter::EncodableValue("bufferingStart")},
-          });
-          auto& codec = flutter::StandardMethodCodec::GetInstance();
-          auto result = codec.EncodeSuccessEnvelope(&res);
-          std::stringstream ss_event_name;
-          ss_event_name << kChannelGstreamerEventPrefix << data->texture;
-          auto event_name = ss_event_name.str();
-          data->engine->SendPlatformMessage(event_name.c_str(), result->data(),
-                                            result->size());
+          send_event(data, flutter::EncodableValue(flutter::EncodableMap{
+                               {flutter::EncodableValue("event"),
+                                flutter::EncodableValue("bufferingStart")},
+                           }));
         }
       }
       break;
@@ -515,538 +1783,146 @@ static gboolean sync_bus_call(GstBus* bus, GstMessage* msg, CustomData* data) {
   return TRUE;
 }
 
-GLuint LoadShaders(const GLchar* vsource, const GLchar* fsource) {
-  GLuint shaderProgram;
-  GLint result;
-  GLsizei length;
-  GLchar* info{};
-
-  vertexShader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertexShader, 1, &vsource, nullptr);
-  glCompileShader(vertexShader);
-  glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderInfoLog(vertexShader, 1000, &length, info);
-    FML_DLOG(ERROR) << "Failed to compile " << info;
-    return 0;
-  }
-
-  fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragmentShader, 1, &fsource, nullptr);
-  glCompileShader(fragmentShader);
-  glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderInfoLog(fragmentShader, 1000, &length, info);
-    FML_DLOG(ERROR) << "Fail to compile " << info;
-    return 0;
-  }
-
-  shaderProgram = glCreateProgram();
-  glAttachShader(shaderProgram, vertexShader);
-  glAttachShader(shaderProgram, fragmentShader);
-  glLinkProgram(shaderProgram);
-
-  glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetProgramInfoLog(shaderProgram, 1000, &length, info);
-    FML_DLOG(ERROR) << "Fail to link " << info;
-    return 0;
-  }
-
-  glDetachShader(shaderProgram, vertexShader);
-  glDetachShader(shaderProgram, fragmentShader);
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
-  return shaderProgram;
-}
-
-const char* map_ffmpeg_plugin(AVCodecID codec_id) {
-  switch (codec_id) {
-    case AV_CODEC_ID_4XM:
-      return "avdec_4xm";
-    case AV_CODEC_ID_8BPS:
-      return "avdec_8bps";
-    case AV_CODEC_ID_8SVX_EXP:
-      return "avdec_8svx_exp";
-    case AV_CODEC_ID_8SVX_FIB:
-      return "avdec_8svx_fib";
-    case AV_CODEC_ID_AASC:
-      return "avdec_aasc";
-    case AV_CODEC_ID_AIC:
-      return "avdec_aic";
-    case AV_CODEC_ID_AMV:
-      return "avdec_amv";
-    case AV_CODEC_ID_ASV1:
-      return "avdec_asv1";
-    case AV_CODEC_ID_ASV2:
-      return "avdec_asv2";
-    case AV_CODEC_ID_AVS:
-      return "avdec_avs";
-    case AV_CODEC_ID_BMV_VIDEO:
-      return "avdec_bmv_video";
-      // case AV_CODEC_ID_CAMSTUDIO:
-      //   return "avdec_camstudio";
-      // case AV_CODEC_ID_CAMTASIA:
-      //   return "avdec_camtasia";
-    case AV_CODEC_ID_CAVS:
-      return "avdec_cavs";
-    case AV_CODEC_ID_CFHD:
-      return "avdec_cfhd";
-    case AV_CODEC_ID_CINEPAK:
-      return "avdec_cinepak";
-    case AV_CODEC_ID_CLEARVIDEO:
-      return "avdec_clearvideo";
-    case AV_CODEC_ID_CLJR:
-      return "avdec_cljr";
-    case AV_CODEC_ID_CYUV:
-      return "avdec_cyuv";
-    case AV_CODEC_ID_DDS:
-      return "avdec_dds";
-    case AV_CODEC_ID_DFA:
-      return "avdec_dfa";
-    case AV_CODEC_ID_DIRAC:
-      return "avdec_dirac";
-    case AV_CODEC_ID_DNXHD:
-      return "avdec_dnxhd";
-    case AV_CODEC_ID_DPX:
-      return "avdec_dpx";
-    case AV_CODEC_ID_DSICINVIDEO:
-      return "avdec_dsicinvideo";
-    case AV_CODEC_ID_DVVIDEO:
-      return "avdec_dvvideo";
-    case AV_CODEC_ID_DXA:
-      return "avdec_dxa";
-    case AV_CODEC_ID_DXTORY:
-      return "avdec_dxtory";
-    case AV_CODEC_ID_DXV:
-      return "avdec_dxv";
-    case AV_CODEC_ID_CMV:
-      return "avdec_eacmv";
-    case AV_CODEC_ID_MAD:
-      return "avdec_eamad";
-    case AV_CODEC_ID_TGQ:
-      return "avdec_eatgq";
-    case AV_CODEC_ID_TGV:
-      return "avdec_eatgv";
-    case AV_CODEC_ID_TQI:
-      return "avdec_eatqi";
-    case AV_CODEC_ID_ESCAPE124:
-      return "avdec_escape124";
-    case AV_CODEC_ID_ESCAPE130:
-      return "avdec_escape130";
-    case AV_CODEC_ID_EXR:
-      return "avdec_exr";
-    case AV_CODEC_ID_FFV1:
-      return "avdec_ffv1";
-    case AV_CODEC_ID_FFVHUFF:
-      return "avdec_ffvhuff";
-    case AV_CODEC_ID_FIC:
-      return "avdec_fic";
-    case AV_CODEC_ID_FITS:
-      return "avdec_fits";
-    case AV_CODEC_ID_FLASHSV:
-      return "avdec_flashsv";
-    case AV_CODEC_ID_FLASHSV2:
-      return "avdec_flashsv2";
-    case AV_CODEC_ID_FLIC:
-      return "avdec_flic";
-    case AV_CODEC_ID_FLV1:
-      return "avdec_flv";
-    case AV_CODEC_ID_FMVC:
-      return "avdec_fmvc";
-    case AV_CODEC_ID_FRAPS:
-      return "avdec_fraps";
-    case AV_CODEC_ID_FRWU:
-      return "avdec_frwu";
-    case AV_CODEC_ID_G2M:
-      return "avdec_g2m";
-    case AV_CODEC_ID_GDV:
-      return "advec_gdv";
-    case AV_CODEC_ID_H261:
-      return "avdec_h261";
-    case AV_CODEC_ID_H263:
-      return "avdec_h263";
-    case AV_CODEC_ID_H263I:
-      return "avdec_h263i";
-    case AV_CODEC_ID_H263P:
-      return "avdec_h263p";
-    case AV_CODEC_ID_H264:
-      return "avdec_h264";
-    case AV_CODEC_ID_H265:
-      return "avdec_h265";
-    case AV_CODEC_ID_HAP:
-      return "avdec_hap";
-    case AV_CODEC_ID_HNM4_VIDEO:
-      return "avdec_hmn4video";
-    case AV_CODEC_ID_HQ_HQA:
-      return "avdec_hq_hqa";
-    case AV_CODEC_ID_HQX:
-      return "avdec_hqx";
-    case AV_CODEC_ID_HUFFYUV:
-      return "avdec_huffyuv";
-    case AV_CODEC_ID_HYMT:
-      return "avdec_hymt";
-      // case AV_CODEC_ID_IDCINVIDEO:
-      //   return "avdec_idcinvideo";
-    case AV_CODEC_ID_IDF:
-      return "avdec_idf";
-      // case AV_CODEC_ID_IFF:
-      //   return "avdec_iff";
-    case AV_CODEC_ID_IMM4:
-      return "avdec_imm4";
-    case AV_CODEC_ID_INDEO2:
-      return "avdec_indeo2";
-    case AV_CODEC_ID_INDEO3:
-      return "avdec_indeo3";
-    case AV_CODEC_ID_INDEO4:
-      return "avdec_indeo4";
-    case AV_CODEC_ID_INDEO5:
-      return "avdec_indeo5";
-    case AV_CODEC_ID_INTERPLAY_VIDEO:
-      return "avdec_interplayvideo";
-    case AV_CODEC_ID_JPEG2000:
-      return "avdec_jpeg2000";
-    case AV_CODEC_ID_JPEGLS:
-      return "avdec_jpegls";
-    case AV_CODEC_ID_JV:
-      return "avdec_jv";
-    case AV_CODEC_ID_KGV1:
-      return "avdec_kgv1";
-    case AV_CODEC_ID_KMVC:
-      return "avdec_kmvc";
-    case AV_CODEC_ID_LAGARITH:
-      return "avdec_lagarith";
-    case AV_CODEC_ID_LOCO:
-      return "avdec_loco";
-    case AV_CODEC_ID_LSCR:
-      return "avdec_lscr";
-    case AV_CODEC_ID_M101:
-      return "avdec_m101";
-    case AV_CODEC_ID_MAGICYUV:
-      return "avdec_magicyuv";
-    case AV_CODEC_ID_MDEC:
-      return "avdec_mdec";
-    case AV_CODEC_ID_MIMIC:
-      return "avdec_mimic";
-    case AV_CODEC_ID_MJPEG:
-      return "avdec_mjpeg";
-    case AV_CODEC_ID_MJPEGB:
-      return "avdec_mjpegb";
-    case AV_CODEC_ID_MMVIDEO:
-      return "avdec_mmvideo";
-    case AV_CODEC_ID_MOTIONPIXELS:
-      return "avdec_motionpixels";
-    case AV_CODEC_ID_MPEG2VIDEO:
-      return "avdec_mpeg2video";
-    case AV_CODEC_ID_MPEG4:
-      return "avdec_mpeg4";
-    case AV_CODEC_ID_MPEG1VIDEO:
-      return "avdec_mpegvideo";
-    case AV_CODEC_ID_MSA1:
-      return "avdec_msa1";
-    case AV_CODEC_ID_MSCC:
-      return "avdec_mscc";
-    case AV_CODEC_ID_MSMPEG4V3:
-      return "avdec_msmpeg4";
-    case AV_CODEC_ID_MSMPEG4V1:
-      return "avdec_msmpeg4v1";
-    case AV_CODEC_ID_MSMPEG4V2:
-      return "avdec_msmpeg4v2";
-    case AV_CODEC_ID_MSRLE:
-      return "avdec_msrle";
-    case AV_CODEC_ID_MSS1:
-      return "avdec_mss1";
-    case AV_CODEC_ID_MSS2:
-      return "avdec_mss2";
-    case AV_CODEC_ID_MSVIDEO1:
-      return "avdec_msvideo1";
-    case AV_CODEC_ID_MSZH:
-      return "avdec_mszh";
-    case AV_CODEC_ID_MTS2:
-      return "avdec_mts2";
-    case AV_CODEC_ID_MVC1:
-      return "avdec_mvc1";
-    case AV_CODEC_ID_MVC2:
-      return "avdec_mvc2";
-    case AV_CODEC_ID_MWSC:
-      return "avdec_mwsc";
-    case AV_CODEC_ID_MXPEG:
-      return "avdec_mxpeg";
-    case AV_CODEC_ID_NUV:
-      return "avdec_NUV";
-    case AV_CODEC_ID_PAF_VIDEO:
-      return "avdec_paf_video";
-    case AV_CODEC_ID_PAM:
-      return "avdec_pam";
-    case AV_CODEC_ID_PBM:
-      return "avdec_pbm";
-    case AV_CODEC_ID_PCX:
-      return "avdec_pcx";
-    case AV_CODEC_ID_PGM:
-      return "avdec_pgm";
-    case AV_CODEC_ID_PGMYUV:
-      return "avdec_pgmyuv";
-    case AV_CODEC_ID_PICTOR:
-      return "avdec_pictor";
-    case AV_CODEC_ID_PIXLET:
-      return "avdec_pixlet";
-    case AV_CODEC_ID_PNG:
-      return "avdec_png";
-    case AV_CODEC_ID_PPM:
-      return "avdec_ppm";
-    case AV_CODEC_ID_PRORES:
-      return "avdec_prores";
-    case AV_CODEC_ID_PROSUMER:
-      return "avdec_prosumer";
-    case AV_CODEC_ID_PSD:
-      return "avdec_psd";
-    case AV_CODEC_ID_PTX:
-      return "avdec_ptx";
-    case AV_CODEC_ID_QDRAW:
-      return "avdec_qdraw";
-    case AV_CODEC_ID_QPEG:
-      return "avdec_qpeg";
-    case AV_CODEC_ID_QTRLE:
-      return "avdec_qtrle";
-    case AV_CODEC_ID_R10K:
-      return "avdec_r10k";
-    case AV_CODEC_ID_RASC:
-      return "avdec_rasc";
-    case AV_CODEC_ID_RL2:
-      return "avdec_rl2";
-    case AV_CODEC_ID_ROQ:
-      return "avdec_roqvideo";
-    case AV_CODEC_ID_RPZA:
-      return "avdec_rpza";
-    case AV_CODEC_ID_RSCC:
-      return "avdec_rscc";
-    case AV_CODEC_ID_RV10:
-      return "avdec_rv10";
-    case AV_CODEC_ID_RV20:
-      return "avdec_rv20";
-    case AV_CODEC_ID_RV30:
-      return "avdec_rv30";
-    case AV_CODEC_ID_RV40:
-      return "avdec_rv40";
-    case AV_CODEC_ID_SANM:
-      return "avdec_sanm";
-    case AV_CODEC_ID_SCPR:
-      return "avdec_scpr";
-    case AV_CODEC_ID_SCREENPRESSO:
-      return "avdec_screenpresso";
-    case AV_CODEC_ID_SGI:
-      return "avdec_sgi";
-    case AV_CODEC_ID_SGIRLE:
-      return "avdec_sgirle";
-    case AV_CODEC_ID_SHEERVIDEO:
-      return "avdec_sheervideo";
-    case AV_CODEC_ID_SMACKVIDEO:
-      return "avdec_smackvid";
-    case AV_CODEC_ID_SMC:
-      return "avdec_smc";
-    case AV_CODEC_ID_SMVJPEG:
-      return "avdec_smvjpeg";
-    case AV_CODEC_ID_SNOW:
-      return "avdec_snow";
-    case AV_CODEC_ID_SP5X:
-      return "avdec_sp5x";
-    case AV_CODEC_ID_SPEEDHQ:
-      return "avdec_speedhq";
-    case AV_CODEC_ID_SRGC:
-      return "avdec_srgc";
-    case AV_CODEC_ID_SUNRAST:
-      return "avdec_sunrast";
-    case AV_CODEC_ID_SVQ1:
-      return "avdec_svq1";
-    case AV_CODEC_ID_SVQ3:
-      return "avdec_svq3";
-    case AV_CODEC_ID_TARGA:
-      return "avdec_targa";
-    case AV_CODEC_ID_TARGA_Y216:
-      return "avdec_targa_y216";
-    case AV_CODEC_ID_TDSC:
-      return "avdec_tdsc";
-    case AV_CODEC_ID_THP:
-      return "avdec_thp";
-    case AV_CODEC_ID_TIERTEXSEQVIDEO:
-      return "avdec_tiertexseqvideo";
-    case AV_CODEC_ID_TIFF:
-      return "avdec_tiff";
-    case AV_CODEC_ID_TMV:
-      return "avdec_tmv";
-    case AV_CODEC_ID_TRUEHD:
-      return "avdec_truehd";
-    case AV_CODEC_ID_TRUEMOTION1:
-      return "avdec_truemotion1";
-    case AV_CODEC_ID_TRUEMOTION2:
-      return "avdec_truemotion2";
-    case AV_CODEC_ID_TRUEMOTION2RT:
-      return "avdec_truemotion2rt";
-    case AV_CODEC_ID_TSCC2:
-      return "avdec_tscc2";
-    case AV_CODEC_ID_TXD:
-      return "avdec_txd";
-      // case AV_CODEC_ID_ULTIMOTION:
-      //   return "avdec_ultimotion";
-    case AV_CODEC_ID_UTVIDEO:
-      return "avdec_utvideo";
-    case AV_CODEC_ID_VB:
-      return "avdec_vb";
-    case AV_CODEC_ID_VBLE:
-      return "avdec_vble";
-    case AV_CODEC_ID_VC1:
-      return "avdec_vc1";
-    case AV_CODEC_ID_VC1IMAGE:
-      return "avdec_vc1image";
-    case AV_CODEC_ID_VCR1:
-      return "avdec_vcr1";
-    case AV_CODEC_ID_VMDVIDEO:
-      return "avdec_vmdvideo";
-    case AV_CODEC_ID_VMNC:
-      return "avdec_vmnc";
-    case AV_CODEC_ID_VP3:
-      return "avdec_vp3";
-    case AV_CODEC_ID_VP4:
-      return "avdec_vp4";
-    case AV_CODEC_ID_VP5:
-      return "avdec_vp5";
-    case AV_CODEC_ID_VP6:
-      return "avdec_vp6";
-    case AV_CODEC_ID_VP6A:
-      return "avdec_vp6a";
-    case AV_CODEC_ID_VP6F:
-      return "avdec_vp6f";
-    case AV_CODEC_ID_VP7:
-      return "avdec_vp7";
-    case AV_CODEC_ID_VP8:
-      return "avdec_vp8";
-    case AV_CODEC_ID_VP9:
-      return "avdec_vp9";
-    case AV_CODEC_ID_WS_VQA:
-      return "avdec_vqavideo";
-    case AV_CODEC_ID_WCMV:
-      return "avdec_wcmv";
-    case AV_CODEC_ID_WEBP:
-      return "avdec_webp";
-    case AV_CODEC_ID_WMV1:
-      return "avdec_wmv1";
-    case AV_CODEC_ID_WMV2:
-      return "avdec_wmv2";
-    case AV_CODEC_ID_WMV3:
-      return "avdec_wmv3";
-    case AV_CODEC_ID_WMV3IMAGE:
-      return "avdec_wmv3image";
-    case AV_CODEC_ID_WNV1:
-      return "avdec_wnv1";
-    case AV_CODEC_ID_XAN_WC3:
-      return "avdec_xan_wc3";
-    case AV_CODEC_ID_XAN_WC4:
-      return "avdec_xan_wc4";
-    case AV_CODEC_ID_XBIN:
-      return "avdec_xbin";
-    case AV_CODEC_ID_XBM:
-      return "avdec_xbm";
-    case AV_CODEC_ID_XFACE:
-      return "avdec_xface";
-      // case AV_CODEC_ID_XL:
-      //   return "avdec_xl";
-    case AV_CODEC_ID_XPM:
-      return "avdec_xpm";
-    case AV_CODEC_ID_XWD:
-      return "avdec_xwd";
-    case AV_CODEC_ID_YLC:
-      return "avdec_ylc";
-    case AV_CODEC_ID_YOP:
-      return "avdec_yop";
-    case AV_CODEC_ID_ZEROCODEC:
-      return "avdec_zerocodec";
-    case AV_CODEC_ID_ZMBV:
-      return "avdec_zmbv";
-    default:
-      FML_DLOG(ERROR) << "not supported";
-      return "";
+// Requires a context of the engine share group to be current.
+bool acquire_gl_resources() {
+  std::lock_guard<std::mutex> lock(gl_resources_mutex);
+  if (gl_resources.refs++ > 0) {
+    return gl_resources.vertexbuffer != 0;
   }
-}
 
-void main_loop(CustomData* data) {
-  FML_DLOG(INFO) << "[main_loop] start data thread "
-                 << "- textureId: " << data->texture->GetTextureId();
-  GMainContext* context = g_main_context_new();
-  g_main_context_push_thread_default(context);
+  glGenBuffers(1, &gl_resources.vertexbuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, gl_resources.vertexbuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(yuv::kQuadVertices), yuv::kQuadVertices,
+               GL_STATIC_DRAW);
 
-  data->playbin = gst_element_factory_make("playbin", nullptr);
-  assert(data->playbin);
-  g_object_set(data->playbin, "uri", data->uri.c_str(), nullptr);
+  glGenBuffers(1, &gl_resources.coordbuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, gl_resources.coordbuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(yuv::kQuadTexcoords),
+               yuv::kQuadTexcoords, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  gint flags = 0;
-  g_object_get(data->playbin, "flags", &flags, nullptr);
-  flags |= GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_AUDIO;
-  flags &= ~GST_PLAY_FLAG_TEXT;
-  g_object_set(data->playbin, "flags", flags, nullptr);
-  g_object_set(data->playbin, "connection-speed", 56, nullptr);
+  return gl_resources.vertexbuffer != 0;
+}
+
+// Requires a context of the engine share group to be current and a
+// reference taken with acquire_gl_resources().
+GLuint get_program(yuv::Format format) {
+  std::lock_guard<std::mutex> lock(gl_resources_mutex);
+  if (gl_resources.programs[format] == 0) {
+    gl_resources.programs[format] = yuv::CreateProgram(format);
+  }
+  return gl_resources.programs[format];
+}
+
+// Requires a context of the engine share group to be current.
+void release_gl_resources() {
+  std::lock_guard<std::mutex> lock(gl_resources_mutex);
+  if (gl_resources.refs == 0 || --gl_resources.refs > 0) {
+    return;
+  }
+  for (auto program : gl_resources.programs) {
+    if (program) {
+      glDeleteProgram(program);
+    }
+  }
+  glDeleteBuffers(1, &gl_resources.vertexbuffer);
+  glDeleteBuffers(1, &gl_resources.coordbuffer);
+  gl_resources = {};
+}
 
-  data->sink = gst_element_factory_make("fakesink", nullptr);
+// Video branch of the player: appsink, render worker and the bin that
+// playbin uses as its video sink.
+static bool setup_video_sink(CustomData* data) {
+  data->sink = gst_element_factory_make("appsink", nullptr);
   assert(data->sink);
-  g_object_set(data->sink, "sync", TRUE, nullptr);
-  g_object_set(data->sink, "signal-handoffs", TRUE, nullptr);
-  g_object_set(data->sink, "can-activate-pull", TRUE, nullptr);
-  gulong sig =
-      g_signal_connect(data->sink, "handoff", (GCallback)handoff_handler, data);
-  FML_DLOG(INFO) << "[main_loop] register signal " << sig;
-
-  auto decoder_factory =
-      gst_element_factory_find(map_ffmpeg_plugin(data->codec_id));
-  if (decoder_factory == nullptr) {
-    FML_LOG(ERROR) << "Failed to find decoder: "
-                   << map_ffmpeg_plugin(data->codec_id);
-  }
-  data->decoder = gst_element_factory_create(decoder_factory, "decoder");
-  assert(data->decoder);
+  g_object_set(data->sink, "enable-last-sample", FALSE, "emit-signals", FALSE,
+               nullptr);
+  configure_sink(data);
+  GstAppSinkCallbacks callbacks{};
+  callbacks.new_preroll = on_new_preroll;
+  callbacks.new_sample = on_new_sample;
+  gst_app_sink_set_callbacks(GST_APP_SINK(data->sink), &callbacks, data,
+                             nullptr);
+
+  // Frames reach the appsink in the decoder's own format and, up to a
+  // limit, its own size; the shader converts and scales them.  videoconvert
+  // only does work for decoders whose output the shaders do not cover, and
+  // videoscale only for frames much larger than the output.
+  set_sink_caps(data);
 
   data->videoconvert = gst_element_factory_make("videoconvert", nullptr);
   assert(data->videoconvert);
-
-  GstCaps* caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING,
-                                      "NV12", nullptr);
-
   data->videoscale = gst_element_factory_make("videoscale", nullptr);
   assert(data->videoscale);
 
-  GstCaps* scale =
-      gst_caps_new_simple("video/x-raw", "width", G_TYPE_INT, data->width,
-                          "height", G_TYPE_INT, data->height, nullptr);
-
   data->pipeline = gst_bin_new(nullptr);
 
-  gst_bin_add_many((GstBin*)data->pipeline, data->decoder, data->videoconvert,
+  gst_bin_add_many((GstBin*)data->pipeline, data->videoconvert,
                    data->videoscale, data->sink, nullptr);
-  if (!gst_element_link(data->decoder, data->videoconvert)) {
-    FML_DLOG(ERROR) << "Failed to link decoder with videoconvert";
-  }
 
-  if (!gst_element_link_filtered(data->videoconvert, data->videoscale, caps)) {
-    FML_DLOG(ERROR)
-        << "Failed to link videoconvert with videoscale using filter";
+  if (!gst_element_link_many(data->videoconvert, data->videoscale, data->sink,
+                             nullptr)) {
+    FML_DLOG(ERROR) << "Failed to link videoconvert, videoscale and appsink";
   }
 
-  gst_caps_unref(caps);
-
-  GstPad* pad = gst_element_get_static_pad(data->decoder, "sink");
+  GstPad* pad = gst_element_get_static_pad(data->videoconvert, "sink");
   if (gst_pad_is_linked(pad)) {
     FML_DLOG(ERROR) << "already linked, ignore";
-    return;
+    return false;
   }
   GstPad* ghost_pad = gst_ghost_pad_new("sink", pad);
   gst_pad_set_active(ghost_pad, TRUE);
   gst_element_add_pad(data->pipeline, ghost_pad);
   gst_object_unref(pad);
 
-  if (!gst_element_link_filtered(data->videoscale, data->sink, scale)) {
-    FML_DLOG(ERROR) << "Failed to link videoscale with fakesink using filter";
+  g_object_set(data->playbin, "video-sink", data->pipeline, nullptr);
+  return true;
+}
+
+// Player thread.  Builds the pipeline and runs its bus.  Pre-warmed
+// players start without a uri and wait in READY for start_player().
+void main_loop(CustomData* data) {
+  FML_DLOG(INFO) << "[main_loop] start data thread "
+                 << "- uri: " << data->uri;
+  GMainContext* context = g_main_context_new();
+  g_main_context_push_thread_default(context);
+  data->context = context;
+
+  data->playbin = gst_element_factory_make("playbin", nullptr);
+  assert(data->playbin);
+  // owned by the player, released in destroy_player()
+  gst_object_ref_sink(data->playbin);
+  if (!data->uri.empty()) {
+    g_object_set(data->playbin, "uri", data->uri.c_str(), nullptr);
   }
-  gst_caps_unref(scale);
 
-  g_object_set(data->playbin, "video-sink", data->pipeline, nullptr);
+  gint flags = 0;
+  g_object_get(data->playbin, "flags", &flags, nullptr);
+  flags |= GST_PLAY_FLAG_AUDIO;
+  flags &= ~GST_PLAY_FLAG_TEXT;
+  // audio-only players never plug a video decoder or sink
+  if (data->audio_only) {
+    flags &= ~GST_PLAY_FLAG_VIDEO;
+  } else {
+    flags |= GST_PLAY_FLAG_VIDEO;
+  }
+  g_object_set(data->playbin, "flags", flags, nullptr);
+  apply_buffering(data);
+  g_signal_connect(data->playbin, "element-setup",
+                   G_CALLBACK(decoder::Selector::OnElementSetup), nullptr);
+  g_signal_connect(data->playbin, "element-setup",
+                   G_CALLBACK(buffering::OnElementSetup), &data->buffering);
+
+  g_signal_connect(data->playbin, "element-setup",
+                   G_CALLBACK(live_element_setup), data);
+  g_signal_connect(data->playbin, "source-setup", G_CALLBACK(live_source_setup),
+                   data);
+
+  if (!data->audio_only && !setup_video_sink(data)) {
+    stop_render_worker(data);
+    data->barrier.set_value();
+    return;
+  }
 
   GstBus* bus = gst_element_get_bus(data->playbin);
   GSource* bus_source = gst_bus_create_watch(bus);
@@ -1057,10 +1933,16 @@ void main_loop(CustomData* data) {
   g_signal_connect(bus, "message", (GCallback)sync_bus_call, data);
   gst_object_unref(bus);
 
+  // preroll; caps and duration are picked up once PAUSED is reached
+  gst_element_set_state(data->playbin,
+                        data->uri.empty() ? GST_STATE_READY : GST_STATE_PAUSED);
+
   data->main_loop = g_main_loop_new(context, FALSE);
+  data->barrier.set_value();
   g_main_loop_run(data->main_loop);
   g_main_loop_unref(data->main_loop);
   data->main_loop = nullptr;
+  stop_render_worker(data);
   FML_DLOG(INFO) << "[main_loop] mainloop end";
 }
 
@@ -1088,6 +1970,14 @@ void Gstreamer::OnInitialize(const FlutterPlatformMessage* message,
                                                    OnPause);
   PlatformChannel::GetInstance()->RegisterCallback(
       kChannelGstreamerSetMixWithOthers, &Gstreamer::OnSetMixWithOthers);
+  PlatformChannel::GetInstance()->RegisterCallback(kChannelGstreamerStats,
+                                                   OnStats);
+  PlatformChannel::GetInstance()->RegisterCallback(
+      kChannelGstreamerPositionUpdates, OnPositionUpdates);
+  PlatformChannel::GetInstance()->RegisterCallback(
+      kChannelGstreamerSetScrubbing, OnSetScrubbing);
+  PlatformChannel::GetInstance()->RegisterCallback(kChannelGstreamerThumbnail,
+                                                   OnThumbnail);
 
   SendSuccess(engine, message->response_handle);
 }
@@ -1100,26 +1990,23 @@ void OnEvent(const FlutterPlatformMessage* message, void* userdata) {
   auto method = obj->method_name();
 
   GLuint textureId = strtol(&message->channel[34], nullptr, 10);
-  std::shared_ptr<CustomData> data = global_map[textureId];
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
+    FML_LOG(ERROR) << "Video Player Event: unknown textureId " << textureId;
+    auto result = codec.EncodeErrorEnvelope("error", "textureId not found");
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        result->data(), result->size());
+    return;
+  }
 
   if (method == "listen") {
     data->events_enabled = true;
     FML_DLOG(INFO) << "Video Player Event Register: listen " << textureId;
-
-    // send initialized event
-    flutter::EncodableValue res(flutter::EncodableMap{
-        {flutter::EncodableValue("event"),
-         flutter::EncodableValue("initialized")},
-        {flutter::EncodableValue("duration"),
-         flutter::EncodableValue((int)(data->duration / AV_TIME_BASE))},
-        {flutter::EncodableValue("width"),
-         flutter::EncodableValue(data->info.width)},
-        {flutter::EncodableValue("height"),
-         flutter::EncodableValue(data->info.height)},
-    });
-    auto result = codec.EncodeSuccessEnvelope(&res);
-    engine->SendPlatformMessage(message->channel, result->data(),
-                                result->size());
+    auto result = codec.EncodeSuccessEnvelope();
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        result->data(), result->size());
+    // sent here if the pipeline prerolled first, else from prepare()
+    send_initialized_event(data.get());
     return;
   } else if (method == "cancel") {
     FML_DLOG(INFO) << "Video Player Event cancel " << textureId;
@@ -1130,6 +2017,236 @@ void OnEvent(const FlutterPlatformMessage* message, void* userdata) {
   }
 }
 
+// Disposed players are parked here with their pipeline in READY.  Thread,
+// main loop, render worker, EGL context and plane textures stay alive and
+// the next OnCreate only swaps in a uri and a texture.
+// GSTREAMER_PLAYER_POOL=<n> sets the number of parked players, 0 disables
+// pooling.
+static size_t player_pool_size() {
+  static const size_t size = [] {
+    const char* env = getenv("GSTREAMER_PLAYER_POOL");
+    int val = env ? atoi(env) : kDefaultPlayerPoolSize;
+    return val > 0 ? static_cast<size_t>(val) : 0;
+  }();
+  return size;
+}
+
+static std::mutex player_pool_mutex;
+// never destroyed, parked player threads run until process exit
+static auto& player_pool =
+    *new std::list<std::pair<std::string, std::shared_ptr<CustomData>>>();
+
+// Players parked at the same output resolution class are preferred, their
+// plane textures most likely fit the next stream.
+static std::string resolution_class(gint width, gint height) {
+  if (width <= 0 || height <= 0) {
+    return "native";
+  }
+  gint lines = std::min(width, height);
+  if (lines <= 480) {
+    return "sd";
+  } else if (lines <= 720) {
+    return "hd";
+  } else if (lines <= 1080) {
+    return "fhd";
+  }
+  return "uhd";
+}
+
+static std::shared_ptr<CustomData> new_player(Engine* engine,
+                                              bool audio_only = false) {
+  auto data = std::make_shared<CustomData>();
+  data->engine = engine;
+  data->audio_only = audio_only;
+  return data;
+}
+
+// Points a warm player at its uri and prerolls it.
+static void start_player(CustomData* data) {
+  data->barrier_fut.wait();
+  apply_buffering(data);
+  configure_sink(data);
+  set_sink_caps(data);
+  g_object_set(data->playbin, "uri", data->uri.c_str(), nullptr);
+  data->target_state = GST_STATE_PAUSED;
+  gst_element_set_state(data->playbin, GST_STATE_PAUSED);
+}
+
+// Unregisters the player's texture from the engine, so it is no longer
+// sampled, then deletes its GL name if the render worker created one.  A
+// running worker detaches it from the framebuffer first.  Runs with
+// frame_mutex held.
+static void release_texture(Engine* engine, CustomData* data) {
+  if (data->texture == nullptr) {
+    return;
+  }
+  GLuint name = data->texture->GetTextureId();
+  data->texture->Disable();
+  // releases the accounted memory and the registry entries
+  delete data->texture;
+  data->texture = nullptr;
+  if (name == 0) {
+    return;
+  }
+  if (data->render_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(data->render_mutex);
+      data->stale_textures.push_back(name);
+    }
+    data->render_cv.notify_one();
+    return;
+  }
+  engine->GetEglWindow()->MakeTextureCurrent();
+  glDeleteTextures(1, &name);
+  engine->GetEglWindow()->ClearCurrent();
+}
+
+// Tears a player down.  Returns false if the pipeline did not reach NULL.
+static bool destroy_player(Engine* engine, CustomData* data) {
+  data->barrier_fut.wait();
+  data->target_state = GST_STATE_NULL;
+  GstStateChangeReturn ret =
+      gst_element_set_state(data->playbin, GST_STATE_NULL);
+  // main_loop() returns early when the video bin cannot be set up
+  if (data->main_loop) {
+    g_main_loop_quit(data->main_loop);
+  }
+  data->gthread.join();
+  {
+    std::lock_guard<std::mutex> lock(data->frame_mutex);
+    release_texture(engine, data);
+  }
+  if (ret == GST_STATE_CHANGE_FAILURE) {
+    return false;
+  }
+  // the video bin and its elements belong to playbin
+  gst_object_unref(data->playbin);
+  data->playbin = nullptr;
+  data->pipeline = nullptr;
+
+  // the player context may still be bound to a streaming thread, so shared
+  // objects are released through the texture context
+  if (data->context_ready) {
+    engine->GetEglWindow()->MakeTextureCurrent();
+    delete data->shader;
+    data->shader = nullptr;
+    release_gl_resources();
+    engine->GetEglWindow()->ClearCurrent();
+    data->context_ready = false;
+    data->gl_ready = false;
+  }
+  // VAO and framebuffer go away with the player context
+  if (data->egl_context != EGL_NO_CONTEXT) {
+    engine->GetEglWindow()->DestroyProducerContext(data->egl_context);
+    data->egl_context = EGL_NO_CONTEXT;
+  }
+  return true;
+}
+
+// Resets a disposed player and parks it.  Its texture id belongs to the
+// Flutter texture it was created for, so only that texture is deleted.
+// Returns false if the player has to be destroyed instead.
+static bool park_player(Engine* engine,
+                        const std::shared_ptr<CustomData>& data) {
+  if (player_pool_size() == 0) {
+    return false;
+  }
+  data->barrier_fut.wait();
+  if (data->main_loop == nullptr) {
+    return false;
+  }
+  data->target_state = GST_STATE_READY;
+  if (gst_element_set_state(data->playbin, GST_STATE_READY) ==
+      GST_STATE_CHANGE_FAILURE) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(data->frame_mutex);
+    release_texture(engine, data.get());
+    data->id = 0;
+    gst_buffer_replace(&data->last_buffer, nullptr);
+    data->gl_ready = false;
+    data->uri.clear();
+    data->initialized = false;
+    data->initialized_sent = false;
+    data->first_frame = false;
+    {
+      std::lock_guard<std::mutex> seek_lock(data->seek_mutex);
+      data->scrubbing = false;
+      data->seek_in_flight = false;
+      data->seek_target = data->scrub_position = data->scrub_keyframe = -1;
+      data->keyframes.reset();
+    }
+    data->events_enabled = false;
+    data->position = 0;
+    data->frame_position = -1;
+    data->duration = 0;
+    data->rate = 0.0;
+    data->is_looping = false;
+    data->is_buffering = false;
+    data->is_live = false;
+    data->low_memory = false;
+    data->output_shift = 0;
+    data->prefetched = false;
+    data->stats.Reset();
+    data->stream_stats = {};
+  }
+
+  std::shared_ptr<CustomData> evicted;
+  {
+    std::lock_guard<std::mutex> lock(player_pool_mutex);
+    player_pool.emplace_back(resolution_class(data->width, data->height),
+                             data);
+    if (player_pool.size() > player_pool_size()) {
+      evicted = std::move(player_pool.front().second);
+      player_pool.pop_front();
+    }
+  }
+  if (evicted) {
+    destroy_player(engine, evicted.get());
+  }
+  FML_DLOG(INFO) << "player parked";
+  return true;
+}
+
+static std::shared_ptr<CustomData> take_pooled_player(const std::string& key) {
+  std::lock_guard<std::mutex> lock(player_pool_mutex);
+  if (player_pool.empty()) {
+    return nullptr;
+  }
+  auto search = std::find_if(
+      player_pool.begin(), player_pool.end(),
+      [&key](const auto& entry) { return entry.first == key; });
+  if (search == player_pool.end()) {
+    search = player_pool.begin();
+  }
+  auto data = std::move(search->second);
+  player_pool.erase(search);
+  return data;
+}
+
+// Once an app plays video, the pool is filled with players that have a
+// pipeline but no uri yet.
+static void prewarm_players(Engine* engine) {
+  static std::once_flag prewarm_flag;
+  std::call_once(prewarm_flag, [engine] {
+    std::lock_guard<std::mutex> lock(player_pool_mutex);
+    while (player_pool.size() < player_pool_size()) {
+      auto data = new_player(engine);
+      data->gthread = std::thread{main_loop, data.get()};
+      player_pool.emplace_back(resolution_class(0, 0), std::move(data));
+    }
+  });
+}
+
+static std::string asset_uri(Engine* engine, const std::string& asset_path) {
+  if (asset_path[0] == '/') {
+    return paths::JoinPaths({kUriPrefixFile, asset_path});
+  }
+  return paths::JoinPaths(
+      {kUriPrefixFile, engine->GetAssetDirectory(), asset_path});
+}
+
 void Gstreamer::OnCreate(const FlutterPlatformMessage* message,
                          void* userdata) {
   PrintMessageAsHex(message);
@@ -1138,21 +2255,17 @@ void Gstreamer::OnCreate(const FlutterPlatformMessage* message,
   auto obj = codec.DecodeMessage(message->message, message->message_size);
   flutter::EncodableValue val = *obj;
   auto args = std::get_if<flutter::EncodableMap>(&val);
-  auto data = new CustomData();
-  //  data->barrier = std::promise<void>();
-  //  data->barrier_fut = data->barrier.get_future();
-  data->engine = engine;
-  data->initialized = false;
-  data->events_enabled = false;
+  std::string uri;
+  gint width = 0, height = 0;
   auto it = args->find(flutter::EncodableValue("uri"));
   if (it != args->end() && !it->second.IsNull()) {
     if (std::holds_alternative<std::string>(it->second)) {
-      data->uri = std::get<std::string>(it->second);
-      if (data->uri.empty()) {
+      uri = std::get<std::string>(it->second);
+      if (uri.empty()) {
         FML_DLOG(ERROR) << "uri is empty";
         return;
       }
-      FML_DLOG(INFO) << "load uri: " << data->uri;
+      FML_DLOG(INFO) << "load uri: " << uri;
     }
   }
   it = args->find(flutter::EncodableValue("asset"));
@@ -1160,36 +2273,21 @@ void Gstreamer::OnCreate(const FlutterPlatformMessage* message,
     if (std::holds_alternative<std::string>(it->second)) {
       std::string asset_path = std::get<std::string>(it->second);
       FML_DLOG(INFO) << "asset_path: " << asset_path;
-      if (asset_path[0] == '/') {
-        data->uri.assign(paths::JoinPaths({kUriPrefixFile, asset_path}));
-      } else {
-        data->uri.assign(paths::JoinPaths(
-            {kUriPrefixFile, engine->GetAssetDirectory(), asset_path}));
-      }
-      FML_DLOG(INFO) << "asset uri: " << data->uri;
+      uri = asset_uri(engine, asset_path);
+      FML_DLOG(INFO) << "asset uri: " << uri;
     }
   }
 
-  // Get stream information
-  if (!get_video_info(data->uri.c_str(), data->info.width, data->info.height,
-                      data->duration, data->codec_id)) {
-    FML_LOG(ERROR) << "Failed to get video info";
-  }
-
   it = args->find(flutter::EncodableValue("width"));
   if (it != args->end()) {
     flutter::EncodableValue encodedValue = it->second;
 
-    data->width = std::get<int32_t>(encodedValue);
-  } else {
-    data->width = data->info.width;
+    width = std::get<int32_t>(encodedValue);
   }
   it = args->find(flutter::EncodableValue("height"));
   if (it != args->end()) {
     flutter::EncodableValue encodedValue = it->second;
-    data->height = std::get<int32_t>(encodedValue);
-  } else {
-    data->height = data->info.height;
+    height = std::get<int32_t>(encodedValue);
   }
 
   it = args->find(flutter::EncodableValue("packageName"));
@@ -1208,96 +2306,89 @@ void Gstreamer::OnCreate(const FlutterPlatformMessage* message,
   if (it != args->end() && !it->second.IsNull()) {
     if (std::holds_alternative<std::string>(it->second)) {
       FML_DLOG(INFO) << "httpHeaders: " << std::get<std::string>(it->second);
-    }
-  }
-
-  GLuint textureId = -1;
-
-  std::lock_guard<std::mutex> lock(gst_mutex);
-
-  gst_init(nullptr, nullptr);
-  engine->GetEglWindow()->MakeTextureCurrent();
-
-  glGenVertexArrays(1, &vertex_arr_id);
-  glBindVertexArray(vertex_arr_id);
-
-  GLuint texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  textureId = texture;
-
-  glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT);
-
-  gint size = data->width * data->height * 3;
-  auto buffer = new unsigned char[size]{0};
-
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, data->width, data->height, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, buffer);
-  delete[] buffer;
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glGenerateMipmap(GL_TEXTURE_2D);
-
-  FML_DLOG(INFO) << "fetch Texture: " << textureId;
-  data->texture =
-      new Texture(textureId, GL_TEXTURE_2D, GL_RGBA8, nullptr, nullptr);
-  auto engine_shr = std::shared_ptr<Engine>(engine);
-  data->texture->SetEngine(engine_shr);
-
-  data->shader =
-      new nv12::Shader(LoadShaders(vertexSource, nv12::fragmentSource),
-                       textureId, data->width, data->height);
-
-  static const GLfloat g_vertex_buffer_data[] = {
-      -0.5f, 0.5f,  0.0f, 0.5f,  0.5f,  0.0f, 0.5f,  -0.5f, 0.0f,
-
-      0.5f,  -0.5f, 0.0f, -0.5f, -0.5f, 0.0f, -0.5f, 0.5f,  0.0f,
-  };
-
-  glGenBuffers(1, &vertexbuffer);
-  glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data),
-               g_vertex_buffer_data, GL_STATIC_DRAW);
+    }
+  }
+  std::string buffering_profile;
+  it = args->find(flutter::EncodableValue("bufferingProfile"));
+  if (it != args->end() && std::holds_alternative<std::string>(it->second)) {
+    buffering_profile = std::get<std::string>(it->second);
+  }
+  // camera feeds; RTSP, RTP, UDP and SRT uris are live by default
+  bool low_latency = is_live_uri(uri);
+  it = args->find(flutter::EncodableValue("lowLatency"));
+  if (it != args->end() && std::holds_alternative<bool>(it->second)) {
+    low_latency = std::get<bool>(it->second);
+  }
+  // no video branch or texture at all; without it players detect audio-only
+  // media from its streams and never start their video resources
+  bool audio_only = false;
+  it = args->find(flutter::EncodableValue("audioOnly"));
+  if (it != args->end() && std::holds_alternative<bool>(it->second)) {
+    audio_only = std::get<bool>(it->second);
+  }
 
-  static const GLfloat coord_buffer_data[] = {
-      0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+  static std::atomic<int64_t> next_player_id{kPlayerIdBase};
+  int64_t textureId = -1;
 
-      1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-  };
-  glGenBuffers(1, &coordbuffer);
-  glBindBuffer(GL_ARRAY_BUFFER, coordbuffer);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(coord_buffer_data), coord_buffer_data,
-               GL_STATIC_DRAW);
+  std::lock_guard<std::mutex> lock(gst_mutex);
 
-  glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glEnableVertexAttribArray(1);
-  glBindBuffer(GL_ARRAY_BUFFER, coordbuffer);
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-  glDisableVertexAttribArray(0);
+  gst_init(nullptr, nullptr);
+  decoder::Selector::GetInstance().Initialize();
 
-  glFinish();
-  engine->GetEglWindow()->ClearCurrent();
-  data->texture->Enable(textureId);
-  FML_DLOG(INFO) << "Register " << data->texture->GetTextureId() << " done";
+  // pooled players carry a video branch, audio players are never pooled
+  std::shared_ptr<CustomData> data;
+  if (!audio_only) {
+    data = take_pooled_player(resolution_class(width, height));
+  }
+  bool warm = data != nullptr;
+  if (warm) {
+    // a pre-warmed player may still be building its pipeline
+    data->barrier_fut.wait();
+  } else {
+    data = new_player(engine, audio_only);
+  }
+  data->uri = uri;
+  data->width = width;
+  data->height = height;
+  data->create_time = std::chrono::steady_clock::now();
+  data->buffering.profile = &buffering::Lookup(buffering_profile.c_str());
+  data->buffering.temp_template = download_template();
+  data->is_live = low_latency;
+
+  textureId = next_player_id++;
+  FML_DLOG(INFO) << "player: " << textureId << (warm ? " (warm)" : "")
+                 << (audio_only ? " (audio only)" : "");
+  if (!audio_only) {
+    // Flutter knows the texture by the player id.  The GL name, storage
+    // and shader objects are created by the render worker once the stream
+    // has video, see setup_gl().
+    {
+      std::lock_guard<std::mutex> frame_lock(data->frame_mutex);
+      data->texture =
+          new Texture(textureId, GL_TEXTURE_2D, GL_RGBA8, nullptr, nullptr);
+    }
+    // the engine outlives its players, the texture must not own it
+    auto engine_shr = std::shared_ptr<Engine>(engine, [](Engine*) {});
+    data->texture->SetEngine(engine_shr);
+    data->texture->EnableDeferred();
+    data->texture->SetMemoryPressureCallback(on_memory_pressure);
+    FML_DLOG(INFO) << "Register " << textureId << " done";
+  }
+  data->id = textureId;
 
   std::stringstream ss_event_name;
   ss_event_name << kChannelGstreamerEventPrefix << textureId;
   auto event_name = ss_event_name.str();
   FML_DLOG(INFO) << "Register Stream: " << event_name;
 
-  global_map[textureId] = std::shared_ptr<CustomData>(data);
+  add_player(textureId, data);
   PlatformChannel::GetInstance()->RegisterCallback(event_name.c_str(), OnEvent);
 
-  data->gthread = std::thread{main_loop, data};
+  if (warm) {
+    start_player(data.get());
+  } else {
+    data->gthread = std::thread{main_loop, data.get()};
+  }
 
   flutter::EncodableValue result(
       flutter::EncodableMap{{flutter::EncodableValue("textureId"),
@@ -1310,6 +2401,10 @@ void Gstreamer::OnCreate(const FlutterPlatformMessage* message,
   auto encoded = codec.EncodeMessage(value);
   engine->SendPlatformMessageResponse(message->response_handle, encoded->data(),
                                       encoded->size());
+
+  if (!audio_only) {
+    prewarm_players(engine);
+  }
 }
 
 flutter::EncodableValue dispose_error(const char* error_msg) {
@@ -1348,35 +2443,26 @@ void Gstreamer::OnDispose(const FlutterPlatformMessage* message,
   GLuint textureId = std::get<int>(it->second);
 
   engine->TextureDispose(textureId);
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = remove_player(textureId);
+  if (!data) {
     auto value = dispose_error("Unable to find textureId");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
+  set_stats_interval(data.get(), 0);
+  set_position_interval(data.get(), 0);
 
-  std::shared_ptr<CustomData> data = search->second;
-
-  gst_object_unref(data->pipeline);
-  data->target_state = GST_STATE_NULL;
-  GstStateChangeReturn ret =
-      gst_element_set_state(data->playbin, GST_STATE_NULL);
-  if (ret == GST_STATE_CHANGE_FAILURE) {
+  bool parked = !data->audio_only && park_player(engine, data);
+  if (!parked && !destroy_player(engine, data.get())) {
     auto value =
         dispose_error("Unable to see the pipeline change to play state");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
-    g_main_loop_quit(data->main_loop);
-    gst_object_unref(data->pipeline);
-    data->gthread.join();
     return;
   }
-  g_main_loop_quit(data->main_loop);
-  g_main_loop_unref(data->main_loop);
-  data->gthread.join();
   FML_DLOG(INFO) << "dispose done";
 
   SendSuccess(engine, message->response_handle);
@@ -1417,15 +2503,14 @@ void Gstreamer::OnSetLooping(const FlutterPlatformMessage* message,
 
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = setLooping_error("setLooping textureId not found");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
-  std::shared_ptr<CustomData> data = search->second;
   it = args->find(flutter::EncodableValue("isLooping"));
   if (it == args->end()) {
     auto value = setLooping_error("setLooping requires isLooping");
@@ -1463,15 +2548,14 @@ void Gstreamer::OnSetVolume(const FlutterPlatformMessage* message,
 
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = setLooping_error("setVolume textureId not found");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
-  std::shared_ptr<CustomData> data = search->second;
   it = args->find(flutter::EncodableValue("volume"));
   if (it == args->end()) {
     auto value = setLooping_error("setVolume requires volume");
@@ -1507,15 +2591,14 @@ void Gstreamer::OnSetPlaybackSpeed(const FlutterPlatformMessage* message,
 
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = setLooping_error("setPlaybackSpeed textureId not found");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
-  std::shared_ptr<CustomData> data = search->second;
   it = args->find(flutter::EncodableValue("speed"));
   if (it == args->end()) {
     auto value = setLooping_error("setPlaybackSpeed requires speed");
@@ -1524,28 +2607,15 @@ void Gstreamer::OnSetPlaybackSpeed(const FlutterPlatformMessage* message,
                                         encoded->data(), encoded->size());
     return;
   }
-  data->rate = std::get<double>(it->second);
-
-  gint64 position;
-  if (!gst_element_query_position(data->playbin, GST_FORMAT_TIME, &position)) {
-    FML_LOG(ERROR) << "Unable to retrieve current position";
+  double rate = std::get<double>(it->second);
+  if (rate == 0.0 || !change_rate(data.get(), rate)) {
+    auto value = setLooping_error("setPlaybackSpeed failed");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
     return;
   }
-
-  GstEvent* seek_event;
-  if (data->rate > 0) {
-    seek_event = gst_event_new_seek(
-        data->rate, GST_FORMAT_TIME,
-        (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
-        GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_END, 0);
-  } else {
-    seek_event = gst_event_new_seek(
-        data->rate, GST_FORMAT_TIME,
-        (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
-        GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, position);
-  }
-
-  gst_element_send_event(data->sink, seek_event);
+  data->rate = rate;
 
   FML_DLOG(INFO) << "Playback speed: " << data->rate;
 
@@ -1585,15 +2655,14 @@ void Gstreamer::OnPlay(const FlutterPlatformMessage* message, void* userdata) {
   }
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = play_error("play textureId not found");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
-  std::shared_ptr<CustomData> data = search->second;
   data->target_state = GST_STATE_PLAYING;
   GstStateChangeReturn ret =
       gst_element_set_state(data->playbin, GST_STATE_PLAYING);
@@ -1642,22 +2711,32 @@ void Gstreamer::OnPosition(const FlutterPlatformMessage* message,
   }
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = position_error("textureId not found");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
-  auto data = search->second;
+
+  // push mode, the reply was encoded by the player thread
+  {
+    std::lock_guard<std::mutex> lock(data->position_mutex);
+    if (!data->position_reply.empty()) {
+      engine->SendPlatformMessageResponse(message->response_handle,
+                                          data->position_reply.data(),
+                                          data->position_reply.size());
+      return;
+    }
+  }
 
   if (gst_element_query_position(data->playbin, GST_FORMAT_TIME,
                                  &data->position) &&
       gst_element_query_duration(data->playbin, GST_FORMAT_TIME,
                                  &data->duration)) {
 #if GSTREAMER_DEBUG
-    FML_DLOG(INFO) << "position: " << data->position / AV_TIME_BASE;
+    FML_DLOG(INFO) << "position: " << data->position / GST_MSECOND;
 #endif
   }
 
@@ -1667,8 +2746,8 @@ void Gstreamer::OnPosition(const FlutterPlatformMessage* message,
            {flutter::EncodableValue("textureId"),
             flutter::EncodableValue((int32_t)textureId)},
            {flutter::EncodableValue("position"),
-            flutter::EncodableValue(
-                data->position ? (data->position / AV_TIME_BASE) : 0)},
+            flutter::EncodableValue(static_cast<int64_t>(
+                data->position ? (data->position / GST_MSECOND) : 0))},
        })},
       {flutter::EncodableValue("error"), flutter::EncodableValue()},
   };
@@ -1679,6 +2758,129 @@ void Gstreamer::OnPosition(const FlutterPlatformMessage* message,
                                       encoded->size());
 }
 
+flutter::EncodableValue positionUpdates_error(const char* error_msg) {
+  FML_DLOG(ERROR) << "[positionUpdates error] " << error_msg;
+  return flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("result"), flutter::EncodableValue()},
+      {flutter::EncodableValue("error"),
+       flutter::EncodableValue(flutter::EncodableMap{
+           {flutter::EncodableValue("code"), flutter::EncodableValue("")},
+           {flutter::EncodableValue("message"),
+            flutter::EncodableValue("positionUpdates error")},
+           {flutter::EncodableValue("details"),
+            flutter::EncodableValue(error_msg)},
+       })},
+  });
+}
+
+// Switches a player to push mode: every `intervalMs` the player thread
+// sends `position` and `bufferingUpdate` events and caches the position
+// reply.  0 switches back to polling.
+void Gstreamer::OnPositionUpdates(const FlutterPlatformMessage* message,
+                                  void* userdata) {
+  PrintMessageAsHex(message);
+  auto engine = reinterpret_cast<Engine*>(userdata);
+  auto& codec = flutter::StandardMessageCodec::GetInstance();
+  auto obj = codec.DecodeMessage(message->message, message->message_size);
+  flutter::EncodableValue val = *obj;
+  auto args = std::get_if<flutter::EncodableMap>(&val);
+
+  auto it = args->find(flutter::EncodableValue("textureId"));
+  if (it == args->end()) {
+    auto value = positionUpdates_error("textureId required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+  GLuint textureId = std::get<int>(it->second);
+
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
+    auto value = positionUpdates_error("textureId not found");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+
+  it = args->find(flutter::EncodableValue("intervalMs"));
+  if (it == args->end() || !std::holds_alternative<int32_t>(it->second)) {
+    auto value = positionUpdates_error("intervalMs required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+  set_position_interval(data.get(), std::get<int32_t>(it->second));
+
+  SendSuccess(engine, message->response_handle);
+}
+
+flutter::EncodableValue stats_error(const char* error_msg) {
+  FML_DLOG(ERROR) << "[stats error] " << error_msg;
+  return flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("result"), flutter::EncodableValue()},
+      {flutter::EncodableValue("error"),
+       flutter::EncodableValue(flutter::EncodableMap{
+           {flutter::EncodableValue("code"), flutter::EncodableValue("")},
+           {flutter::EncodableValue("message"),
+            flutter::EncodableValue("stats error")},
+           {flutter::EncodableValue("details"),
+            flutter::EncodableValue(error_msg)},
+       })},
+  });
+}
+
+// Replies with the player statistics.  An optional `intervalMs` argument
+// enables (> 0) or disables (0) periodic `stats` events on the player's
+// event channel.
+void Gstreamer::OnStats(const FlutterPlatformMessage* message,
+                        void* userdata) {
+  PrintMessageAsHex(message);
+  auto engine = reinterpret_cast<Engine*>(userdata);
+  auto& codec = flutter::StandardMessageCodec::GetInstance();
+  auto obj = codec.DecodeMessage(message->message, message->message_size);
+  flutter::EncodableValue val = *obj;
+  auto args = std::get_if<flutter::EncodableMap>(&val);
+
+  auto it = args->find(flutter::EncodableValue("textureId"));
+  if (it == args->end()) {
+    auto value = stats_error("textureId required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+  GLuint textureId = std::get<int>(it->second);
+
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
+    auto value = stats_error("textureId not found");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+
+  it = args->find(flutter::EncodableValue("intervalMs"));
+  if (it != args->end() && std::holds_alternative<int32_t>(it->second)) {
+    set_stats_interval(data.get(), std::get<int32_t>(it->second));
+  }
+
+  auto result = data->stats.ToEncodable();
+  result[flutter::EncodableValue("textureId")] =
+      flutter::EncodableValue((int32_t)textureId);
+
+  flutter::EncodableValue value(flutter::EncodableMap{
+      {flutter::EncodableValue("result"), flutter::EncodableValue(result)},
+      {flutter::EncodableValue("error"), flutter::EncodableValue()},
+  });
+  auto encoded = codec.EncodeMessage(value);
+  engine->SendPlatformMessageResponse(message->response_handle, encoded->data(),
+                                      encoded->size());
+}
+
 flutter::EncodableValue seekTo_error(const char* error_msg) {
   FML_DLOG(ERROR) << "[seekTo error] " << error_msg;
   return flutter::EncodableValue(flutter::EncodableMap{
@@ -1712,15 +2914,14 @@ void Gstreamer::OnSeekTo(const FlutterPlatformMessage* message,
   }
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = seekTo_error("cannot find textureId");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
                                         encoded->data(), encoded->size());
     return;
   }
-  std::shared_ptr<CustomData> data = search->second;
 
   it = args->find(flutter::EncodableValue("position"));
   if (it == args->end()) {
@@ -1731,8 +2932,12 @@ void Gstreamer::OnSeekTo(const FlutterPlatformMessage* message,
     return;
   }
   int pos = std::get<int>(it->second);
-  gint64 position = pos * AV_TIME_BASE;
+  gint64 position = pos * GST_MSECOND;
 
+  if (scrub_seek(data.get(), position)) {
+    SendSuccess(engine, message->response_handle);
+    return;
+  }
   if (!gst_element_seek_simple(
           data->playbin, GST_FORMAT_TIME,
           (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
@@ -1748,6 +2953,180 @@ void Gstreamer::OnSeekTo(const FlutterPlatformMessage* message,
   SendSuccess(engine, message->response_handle);
 }
 
+flutter::EncodableValue setScrubbing_error(const char* error_msg) {
+  FML_DLOG(ERROR) << "[setScrubbing error] " << error_msg;
+  return flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("result"), flutter::EncodableValue()},
+      {flutter::EncodableValue("error"),
+       flutter::EncodableValue(flutter::EncodableMap{
+           {flutter::EncodableValue("code"), flutter::EncodableValue("")},
+           {flutter::EncodableValue("message"),
+            flutter::EncodableValue("setScrubbing error")},
+           {flutter::EncodableValue("details"),
+            flutter::EncodableValue(error_msg)},
+       })},
+  });
+}
+
+// Called with `scrubbing: true` when a seek bar drag starts and `false`
+// when it is released.  Seeks in between snap to keyframes and collapse.
+void Gstreamer::OnSetScrubbing(const FlutterPlatformMessage* message,
+                               void* userdata) {
+  PrintMessageAsHex(message);
+  auto engine = reinterpret_cast<Engine*>(userdata);
+  auto& codec = flutter::StandardMessageCodec::GetInstance();
+  auto obj = codec.DecodeMessage(message->message, message->message_size);
+  flutter::EncodableValue val = *obj;
+  auto args = std::get_if<flutter::EncodableMap>(&val);
+
+  auto it = args->find(flutter::EncodableValue("textureId"));
+  if (it == args->end()) {
+    auto value = setScrubbing_error("textureId required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+  GLuint textureId = std::get<int>(it->second);
+
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
+    auto value = setScrubbing_error("textureId not found");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+
+  it = args->find(flutter::EncodableValue("scrubbing"));
+  if (it == args->end() || !std::holds_alternative<bool>(it->second)) {
+    auto value = setScrubbing_error("scrubbing required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+  set_scrubbing(data.get(), std::get<bool>(it->second));
+
+  SendSuccess(engine, message->response_handle);
+}
+
+flutter::EncodableValue thumbnail_error(const char* error_msg) {
+  FML_DLOG(ERROR) << "[thumbnail error] " << error_msg;
+  return flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("result"), flutter::EncodableValue()},
+      {flutter::EncodableValue("error"),
+       flutter::EncodableValue(flutter::EncodableMap{
+           {flutter::EncodableValue("code"), flutter::EncodableValue("")},
+           {flutter::EncodableValue("message"),
+            flutter::EncodableValue("thumbnail error")},
+           {flutter::EncodableValue("details"),
+            flutter::EncodableValue(error_msg)},
+       })},
+  });
+}
+
+// {uri | asset, positions: [ms], width, height, format: "jpeg" | "png"}
+// replies with {thumbnails: [{position, data, path}]} once the thumbnail
+// pool has decoded them; the platform thread only queues the request.
+void Gstreamer::OnThumbnail(const FlutterPlatformMessage* message,
+                            void* userdata) {
+  PrintMessageAsHex(message);
+  auto engine = reinterpret_cast<Engine*>(userdata);
+  auto& codec = flutter::StandardMessageCodec::GetInstance();
+  auto obj = codec.DecodeMessage(message->message, message->message_size);
+  flutter::EncodableValue val = *obj;
+  auto args = std::get_if<flutter::EncodableMap>(&val);
+
+  thumbnail::Job job{};
+  auto it = args->find(flutter::EncodableValue("uri"));
+  if (it != args->end() && std::holds_alternative<std::string>(it->second)) {
+    job.uri = std::get<std::string>(it->second);
+  }
+  it = args->find(flutter::EncodableValue("asset"));
+  if (it != args->end() && std::holds_alternative<std::string>(it->second) &&
+      !std::get<std::string>(it->second).empty()) {
+    job.uri = asset_uri(engine, std::get<std::string>(it->second));
+  }
+  if (job.uri.empty()) {
+    auto value = thumbnail_error("uri or asset required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+
+  it = args->find(flutter::EncodableValue("positions"));
+  if (it != args->end() &&
+      std::holds_alternative<flutter::EncodableList>(it->second)) {
+    for (const auto& position : std::get<flutter::EncodableList>(it->second)) {
+      if (std::holds_alternative<int32_t>(position)) {
+        job.positions_ms.push_back(std::get<int32_t>(position));
+      } else if (std::holds_alternative<int64_t>(position)) {
+        job.positions_ms.push_back(std::get<int64_t>(position));
+      }
+    }
+  }
+  if (job.positions_ms.empty()) {
+    auto value = thumbnail_error("positions required");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+    return;
+  }
+
+  it = args->find(flutter::EncodableValue("width"));
+  if (it != args->end() && std::holds_alternative<int32_t>(it->second)) {
+    job.width = std::get<int32_t>(it->second);
+  }
+  it = args->find(flutter::EncodableValue("height"));
+  if (it != args->end() && std::holds_alternative<int32_t>(it->second)) {
+    job.height = std::get<int32_t>(it->second);
+  }
+  job.mime = "image/jpeg";
+  it = args->find(flutter::EncodableValue("format"));
+  if (it != args->end() && std::holds_alternative<std::string>(it->second) &&
+      std::get<std::string>(it->second) == "png") {
+    job.mime = "image/png";
+  }
+  job.cache_dir = thumbnail_cache_dir();
+
+  auto response_handle = message->response_handle;
+  job.done = [engine, response_handle](std::vector<thumbnail::Image> images) {
+    flutter::EncodableList thumbnails;
+    for (auto& image : images) {
+      thumbnails.emplace_back(flutter::EncodableMap{
+          {flutter::EncodableValue("position"),
+           flutter::EncodableValue(image.position_ms)},
+          {flutter::EncodableValue("data"),
+           flutter::EncodableValue(std::move(image.data))},
+          {flutter::EncodableValue("path"),
+           flutter::EncodableValue(image.path)},
+      });
+    }
+    flutter::EncodableValue value(flutter::EncodableMap{
+        {flutter::EncodableValue("result"),
+         flutter::EncodableValue(flutter::EncodableMap{
+             {flutter::EncodableValue("thumbnails"),
+              flutter::EncodableValue(std::move(thumbnails))},
+         })},
+        {flutter::EncodableValue("error"), flutter::EncodableValue()},
+    });
+    auto encoded =
+        flutter::StandardMessageCodec::GetInstance().EncodeMessage(value);
+    engine->SendPlatformMessageResponse(response_handle, encoded->data(),
+                                        encoded->size());
+  };
+
+  gst_init(nullptr, nullptr);
+  if (!thumbnail::Pool::GetInstance().Submit(std::move(job))) {
+    auto value = thumbnail_error("too many pending thumbnail requests");
+    auto encoded = codec.EncodeMessage(value);
+    engine->SendPlatformMessageResponse(message->response_handle,
+                                        encoded->data(), encoded->size());
+  }
+}
+
 flutter::EncodableValue pause_error(const char* error_msg) {
   FML_DLOG(ERROR) << "[pause error] " << error_msg;
   return flutter::EncodableValue(flutter::EncodableMap{
@@ -1781,8 +3160,8 @@ void Gstreamer::OnPause(const FlutterPlatformMessage* message, void* userdata) {
   }
   GLuint textureId = std::get<int>(it->second);
 
-  auto search = global_map.find(textureId);
-  if (search == global_map.end()) {
+  std::shared_ptr<CustomData> data = find_player(textureId);
+  if (!data) {
     auto value = pause_error("texture not found");
     auto encoded = codec.EncodeMessage(value);
     engine->SendPlatformMessageResponse(message->response_handle,
@@ -1791,8 +3170,6 @@ void Gstreamer::OnPause(const FlutterPlatformMessage* message, void* userdata) {
   }
 
   FML_DLOG(INFO) << "Pause: " << textureId;
-
-  std::shared_ptr<CustomData> data = search->second;
   GstState state;
   gst_element_get_state(data->playbin, &state, nullptr, GST_CLOCK_TIME_NONE);
   if (state != GST_STATE_NULL) {
@@ -24,6 +24,14 @@ constexpr char kChannelGstreamerPause[] =
     "dev.flutter.pigeon.VideoPlayerApi.pause";
 constexpr char kChannelGstreamerSetMixWithOthers[] =
     "dev.flutter.pigeon.VideoPlayerApi.setMixWithOthers";
+constexpr char kChannelGstreamerStats[] =
+    "dev.flutter.pigeon.VideoPlayerApi.stats";
+constexpr char kChannelGstreamerPositionUpdates[] =
+    "dev.flutter.pigeon.VideoPlayerApi.positionUpdates";
+constexpr char kChannelGstreamerSetScrubbing[] =
+    "dev.flutter.pigeon.VideoPlayerApi.setScrubbing";
+constexpr char kChannelGstreamerThumbnail[] =
+    "dev.flutter.pigeon.VideoPlayerApi.thumbnail";
 constexpr char kChannelGstreamerEventPrefix[] =
     "flutter.io/videoPlayer/videoEvents";
 
@@ -46,4 +54,11 @@ class Gstreamer {
   static void OnPosition(const FlutterPlatformMessage* message, void* userdata);
   static void OnSetMixWithOthers(const FlutterPlatformMessage* message,
                                  void* userdata);
+  static void OnStats(const FlutterPlatformMessage* message, void* userdata);
+  static void OnPositionUpdates(const FlutterPlatformMessage* message,
+                                void* userdata);
+  static void OnSetScrubbing(const FlutterPlatformMessage* message,
+                             void* userdata);
+  static void OnThumbnail(const FlutterPlatformMessage* message,
+                          void* userdata);
 };
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2020 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <flutter/fml/logging.h>
+#include <flutter/fml/paths.h>
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+
+namespace keyframe {
+
+// Caps of the parsed video streams an index is built from.
+constexpr char kIndexCaps[] =
+    "video/x-h264; video/x-h265; video/x-vp8; video/x-vp9; video/x-av1; "
+    "video/mpeg; video/x-theora";
+
+constexpr uint32_t kIndexMagic = 0x3149464b;  // "KFI1"
+
+// indexing gives up when no sample, EOS or error arrives for this long
+constexpr GstClockTime kPullTimeout = GST_SECOND;
+constexpr int kMaxIdlePulls = 10;
+
+// Keyframe timestamps (stream time, ns) of one local media file.  The
+// index is built on a background thread by demuxing and parsing the file,
+// nothing is decoded, and is persisted next to the engine cache keyed by
+// the path, size and modification time.  Until it is ready, Snap() is a
+// no-op and seeks rely on the demuxer's own index.
+class Index {
+ public:
+  // Shared by every player of the same uri.  Returns nullptr for anything
+  // but local files, indexing a network stream means downloading it.
+  static std::shared_ptr<Index> Get(const std::string& uri,
+                                    const std::string& cache_dir) {
+    static std::mutex mutex;
+    static auto& indexes = *new std::map<std::string, std::weak_ptr<Index>>();
+
+    gchar* path = g_filename_from_uri(uri.c_str(), nullptr, nullptr);
+    if (path == nullptr) {
+      return nullptr;
+    }
+    std::string file(path);
+    g_free(path);
+    struct stat st {};
+    if (stat(file.c_str(), &st) != 0) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto index = indexes[uri].lock();
+    if (index) {
+      return index;
+    }
+    std::stringstream key;
+    key << file << ':' << st.st_size << ':' << st.st_mtime;
+    std::stringstream name;
+    name << std::hex << std::hash<std::string>{}(key.str()) << ".idx";
+    index = std::shared_ptr<Index>(
+        new Index(uri, fml::paths::JoinPaths({cache_dir, name.str()})));
+    indexes[uri] = index;
+    if (!index->Load()) {
+      std::thread(&Index::Build, index).detach();
+    }
+    return index;
+  }
+
+  [[nodiscard]] bool Ready() const { return m_ready; }
+
+  // Keyframe nearest to |position|, or |position| while not ready.
+  [[nodiscard]] int64_t Snap(int64_t position) const {
+    if (!m_ready || m_keyframes.empty()) {
+      return position;
+    }
+    auto next = std::lower_bound(m_keyframes.begin(), m_keyframes.end(),
+                                 position);
+    if (next == m_keyframes.end()) {
+      return m_keyframes.back();
+    }
+    if (next == m_keyframes.begin()) {
+      return *next;
+    }
+    auto prev = std::prev(next);
+    return position - *prev <= *next - position ? *prev : *next;
+  }
+
+ private:
+  Index(std::string uri, std::string path)
+      : m_uri(std::move(uri)), m_path(std::move(path)) {}
+
+  bool Load() {
+    FILE* f = fopen(m_path.c_str(), "rb");
+    if (f == nullptr) {
+      return false;
+    }
+    uint32_t magic = 0;
+    uint64_t count = 0;
+    bool ok = fread(&magic, sizeof(magic), 1, f) == 1 &&
+              magic == kIndexMagic && fread(&count, sizeof(count), 1, f) == 1;
+    // a truncated or corrupt file must not size the vector
+    if (ok) {
+      long header = ftell(f);
+      ok = fseek(f, 0, SEEK_END) == 0;
+      long size = ftell(f);
+      ok = ok && header > 0 && size >= header &&
+           count == static_cast<uint64_t>(size - header) / sizeof(int64_t) &&
+           fseek(f, header, SEEK_SET) == 0;
+    }
+    if (ok) {
+      m_keyframes.resize(count);
+      ok = fread(m_keyframes.data(), sizeof(int64_t), count, f) == count;
+    }
+    fclose(f);
+    if (!ok) {
+      m_keyframes.clear();
+      return false;
+    }
+    FML_DLOG(INFO) << "keyframe index loaded, " << count << " keyframes";
+    m_ready = true;
+    return true;
+  }
+
+  void Store() const {
+    std::string tmp = m_path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (f == nullptr) {
+      FML_LOG(ERROR) << "Failed to write keyframe index: " << m_path;
+      return;
+    }
+    uint64_t count = m_keyframes.size();
+    bool ok = fwrite(&kIndexMagic, sizeof(kIndexMagic), 1, f) == 1 &&
+              fwrite(&count, sizeof(count), 1, f) == 1 &&
+              fwrite(m_keyframes.data(), sizeof(int64_t), count, f) == count;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), m_path.c_str()) != 0) {
+      remove(tmp.c_str());
+    }
+  }
+
+  // Runs on a detached thread that owns a reference to the index.
+  void Build() {
+#if GST_CHECK_VERSION(1, 10, 0)
+    std::stringstream desc;
+    desc << "urisourcebin uri=\"" << m_uri << "\" ! parsebin ! appsink "
+         << "name=sink sync=false caps=\"" << kIndexCaps << "\"";
+    GError* error = nullptr;
+    GstElement* pipeline = gst_parse_launch(desc.str().c_str(), &error);
+    if (pipeline == nullptr || error != nullptr) {
+      FML_LOG(ERROR) << "keyframe index pipeline: "
+                     << (error ? error->message : "unknown error");
+      g_clear_error(&error);
+      if (pipeline) {
+        gst_object_unref(pipeline);
+      }
+      return;
+    }
+    GstElement* sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    // Errors (a missing parser, an unlinked stream) stop the data flow
+    // without EOS, so the bus is checked whenever no sample arrives.
+    GstBus* bus = gst_element_get_bus(pipeline);
+    std::vector<int64_t> keyframes;
+    bool failed = false;
+    int idle = 0;
+    while (true) {
+      GstSample* sample =
+          gst_app_sink_try_pull_sample(GST_APP_SINK(sink), kPullTimeout);
+      if (sample == nullptr) {
+        if (gst_app_sink_is_eos(GST_APP_SINK(sink))) {
+          break;
+        }
+        GstMessage* msg =
+            gst_bus_timed_pop_filtered(bus, 0, GST_MESSAGE_ERROR);
+        if (msg) {
+          GError* err = nullptr;
+          gst_message_parse_error(msg, &err, nullptr);
+          FML_LOG(ERROR) << "keyframe index of " << m_uri << ": "
+                         << (err ? err->message : "unknown error");
+          g_clear_error(&err);
+          gst_message_unref(msg);
+          failed = true;
+          break;
+        }
+        if (++idle >= kMaxIdlePulls) {
+          FML_LOG(ERROR) << "keyframe index of " << m_uri << " stalled";
+          failed = true;
+          break;
+        }
+        continue;
+      }
+      idle = 0;
+      GstBuffer* buffer = gst_sample_get_buffer(sample);
+      const GstSegment* segment = gst_sample_get_segment(sample);
+      if (buffer && segment &&
+          !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        GstClockTime ts = GST_BUFFER_PTS_IS_VALID(buffer)
+                              ? GST_BUFFER_PTS(buffer)
+                              : GST_BUFFER_DTS(buffer);
+        guint64 stream_time =
+            gst_segment_to_stream_time(segment, GST_FORMAT_TIME, ts);
+        if (GST_CLOCK_TIME_IS_VALID(stream_time)) {
+          keyframes.push_back(static_cast<int64_t>(stream_time));
+        }
+      }
+      gst_sample_unref(sample);
+    }
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(sink);
+    gst_object_unref(pipeline);
+
+    if (failed || keyframes.empty()) {
+      FML_LOG(ERROR) << "Failed to index keyframes of " << m_uri;
+      return;
+    }
+    std::sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(std::unique(keyframes.begin(), keyframes.end()),
+                    keyframes.end());
+    m_keyframes = std::move(keyframes);
+    m_ready = true;
+    FML_DLOG(INFO) << "keyframe index built, " << m_keyframes.size()
+                   << " keyframes";
+    Store();
+#endif
+  }
+
+  std::string m_uri;
+  std::string m_path;
+  // written once before m_ready is set, read-only afterwards
+  std::vector<int64_t> m_keyframes;
+  std::atomic<bool> m_ready = false;
+};
+
+}  // namespace keyframe
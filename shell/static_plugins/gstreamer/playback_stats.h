@@ -0,0 +1,199 @@
+/*
+ * Copyright 2020 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <flutter/encodable_value.h>
+
+namespace playback {
+
+// Lock free histogram of durations in power of two microsecond buckets,
+// bucket i counting durations below 2^i us; the last bucket is open ended.
+class Histogram {
+ public:
+  static constexpr size_t kBuckets = 18;  // up to ~131 ms
+
+  void Add(int64_t ns) {
+    if (ns < 0) {
+      ns = 0;
+    }
+    uint64_t us = static_cast<uint64_t>(ns) / 1000;
+    size_t bucket = 0;
+    while (bucket < kBuckets - 1 && us >= (1ull << bucket)) {
+      bucket++;
+    }
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total_ns.fetch_add(ns, std::memory_order_relaxed);
+    int64_t max = m_max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !m_max_ns.compare_exchange_weak(
+                           max, ns, std::memory_order_relaxed)) {
+    }
+  }
+
+  [[nodiscard]] double MeanUs() const {
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    return count ? static_cast<double>(m_total_ns.load()) / 1000.0 / count
+                 : 0.0;
+  }
+
+  // Upper bound (us) of the bucket holding the given percentile.
+  [[nodiscard]] int64_t PercentileUs(double percentile) const {
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    if (count == 0) {
+      return 0;
+    }
+    auto target = static_cast<uint64_t>(percentile * count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+      seen += m_buckets[i].load(std::memory_order_relaxed);
+      if (seen > target) {
+        return static_cast<int64_t>(1ull << i);
+      }
+    }
+    return static_cast<int64_t>(1ull << (kBuckets - 1));
+  }
+
+  void Reset() {
+    for (auto& bucket : m_buckets) {
+      bucket = 0;
+    }
+    m_count = 0;
+    m_total_ns = 0;
+    m_max_ns = 0;
+  }
+
+  [[nodiscard]] flutter::EncodableValue ToEncodable() const {
+    uint64_t count = m_count.load(std::memory_order_relaxed);
+    flutter::EncodableList buckets;
+    for (const auto& bucket : m_buckets) {
+      buckets.emplace_back(
+          static_cast<int64_t>(bucket.load(std::memory_order_relaxed)));
+    }
+    return flutter::EncodableValue(flutter::EncodableMap{
+        {flutter::EncodableValue("count"),
+         flutter::EncodableValue(static_cast<int64_t>(count))},
+        {flutter::EncodableValue("meanUs"), flutter::EncodableValue(MeanUs())},
+        {flutter::EncodableValue("maxUs"),
+         flutter::EncodableValue(m_max_ns.load() / 1000)},
+        {flutter::EncodableValue("p50Us"),
+         flutter::EncodableValue(PercentileUs(0.5))},
+        {flutter::EncodableValue("p99Us"),
+         flutter::EncodableValue(PercentileUs(0.99))},
+        {flutter::EncodableValue("buckets"),
+         flutter::EncodableValue(std::move(buckets))},
+    });
+  }
+
+ private:
+  std::atomic<uint64_t> m_buckets[kBuckets]{};
+  std::atomic<uint64_t> m_count{};
+  std::atomic<uint64_t> m_total_ns{};
+  std::atomic<int64_t> m_max_ns{};
+};
+
+// Per-player counters.  Updated from the appsink streaming thread, the
+// render worker and the bus thread; read from the platform thread.
+struct Stats {
+  // frames leaving the decoder into the appsink
+  std::atomic<uint64_t> frames_decoded{};
+  std::atomic<uint64_t> frames_rendered{};
+  // dropped late by the sink (QoS)
+  std::atomic<uint64_t> frames_late{};
+  // samples queued when the render worker woke up
+  std::atomic<uint32_t> queue_depth{};
+  std::atomic<uint32_t> queue_depth_max{};
+  // video running time behind (+) or ahead (-) of the pipeline clock
+  std::atomic<int64_t> av_drift_ns{};
+  std::atomic<int64_t> av_drift_max_ns{};
+  // time from create to the first frame in the texture
+  std::atomic<int64_t> first_frame_ns{};
+  Histogram upload;
+  Histogram convert;
+  // live feeds: buffer capture to texture publish
+  Histogram latency;
+
+  // Appsink drops, worker drops of stale samples and QoS drops.
+  [[nodiscard]] uint64_t FramesDropped() const {
+    uint64_t decoded = frames_decoded;
+    uint64_t rendered = frames_rendered;
+    return (decoded > rendered ? decoded - rendered : 0) + frames_late;
+  }
+
+  void SetQueueDepth(uint32_t depth) {
+    queue_depth = depth;
+    uint32_t max = queue_depth_max.load(std::memory_order_relaxed);
+    while (depth > max && !queue_depth_max.compare_exchange_weak(max, depth)) {
+    }
+  }
+
+  void SetDrift(int64_t drift_ns) {
+    av_drift_ns = drift_ns;
+    int64_t magnitude = std::llabs(drift_ns);
+    int64_t max = av_drift_max_ns.load(std::memory_order_relaxed);
+    while (magnitude > max &&
+           !av_drift_max_ns.compare_exchange_weak(max, magnitude)) {
+    }
+  }
+
+  // A pooled player starts every stream from zero.
+  void Reset() {
+    frames_decoded = 0;
+    frames_rendered = 0;
+    frames_late = 0;
+    queue_depth = 0;
+    queue_depth_max = 0;
+    av_drift_ns = 0;
+    av_drift_max_ns = 0;
+    first_frame_ns = 0;
+    upload.Reset();
+    convert.Reset();
+    latency.Reset();
+  }
+
+  [[nodiscard]] flutter::EncodableMap ToEncodable() const {
+    return flutter::EncodableMap{
+        {flutter::EncodableValue("framesDecoded"),
+         flutter::EncodableValue(static_cast<int64_t>(frames_decoded))},
+        {flutter::EncodableValue("framesRendered"),
+         flutter::EncodableValue(static_cast<int64_t>(frames_rendered))},
+        {flutter::EncodableValue("framesDropped"),
+         flutter::EncodableValue(static_cast<int64_t>(FramesDropped()))},
+        {flutter::EncodableValue("framesLate"),
+         flutter::EncodableValue(static_cast<int64_t>(frames_late))},
+        {flutter::EncodableValue("queueDepth"),
+         flutter::EncodableValue(static_cast<int32_t>(queue_depth))},
+        {flutter::EncodableValue("queueDepthMax"),
+         flutter::EncodableValue(static_cast<int32_t>(queue_depth_max))},
+        {flutter::EncodableValue("avDriftUs"),
+         flutter::EncodableValue(static_cast<int64_t>(av_drift_ns / 1000))},
+        {flutter::EncodableValue("avDriftMaxUs"),
+         flutter::EncodableValue(
+             static_cast<int64_t>(av_drift_max_ns / 1000))},
+        {flutter::EncodableValue("firstFrameUs"),
+         flutter::EncodableValue(static_cast<int64_t>(first_frame_ns / 1000))},
+        {flutter::EncodableValue("uploadTime"), upload.ToEncodable()},
+        {flutter::EncodableValue("convertTime"), convert.ToEncodable()},
+        {flutter::EncodableValue("latency"), latency.ToEncodable()},
+    };
+  }
+};
+
+}  // namespace playback
@@ -0,0 +1,324 @@
+/*
+ * Copyright 2020 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <flutter/fml/logging.h>
+#include <flutter/fml/paths.h>
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "decoder_selector.h"
+
+namespace thumbnail {
+
+// jobs waiting for a worker; further requests are refused
+constexpr size_t kMaxPendingJobs = 64;
+
+// a frame that does not preroll within this is skipped
+constexpr GstClockTime kFrameTimeout = 5 * GST_SECOND;
+
+// playbin GST_PLAY_FLAG_VIDEO
+constexpr gint kPlayFlagVideo = 1 << 0;
+
+struct Image {
+  int64_t position_ms;
+  std::vector<uint8_t> data;
+  std::string path;
+};
+
+struct Job {
+  std::string uri;
+  std::vector<int64_t> positions_ms;
+  // bounding box of the thumbnail, the aspect ratio is kept
+  gint width;
+  gint height;
+  // "image/jpeg" or "image/png"
+  std::string mime;
+  std::string cache_dir;
+  // called on the worker thread, with one image per decodable position
+  std::function<void(std::vector<Image>)> done;
+};
+
+// Extracts downscaled, encoded frames on a small pool of low priority
+// threads, separate from the players.  Each job opens its own video-only
+// pipeline, prerolls on key frames near the requested positions and
+// encodes them with gst_video_convert_sample().  Images are cached on disk
+// keyed by the file, its size and modification time.
+class Pool {
+ public:
+  static Pool& GetInstance() {
+    static Pool& instance = *new Pool();
+    return instance;
+  }
+
+  Pool(const Pool&) = delete;
+  const Pool& operator=(const Pool&) = delete;
+
+  // Returns false if the queue is full.
+  bool Submit(Job job) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_jobs.size() >= kMaxPendingJobs) {
+      return false;
+    }
+    if (m_workers.empty()) {
+      for (int i = 0; i < Threads(); i++) {
+        m_workers.emplace_back(&Pool::Worker, this);
+        m_workers.back().detach();
+      }
+    }
+    m_jobs.push_back(std::move(job));
+    m_cv.notify_one();
+    return true;
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<Job> m_jobs;
+  std::vector<std::thread> m_workers;
+
+  Pool() = default;
+  ~Pool() = default;
+
+  // GSTREAMER_THUMBNAIL_THREADS, default 2
+  static int Threads() {
+    const char* env = getenv("GSTREAMER_THUMBNAIL_THREADS");
+    int val = env ? atoi(env) : 0;
+    return val > 0 ? val : 2;
+  }
+
+  void Worker() {
+    // Lowest priority, the pipelines' streaming threads inherit it.
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_jobs.empty(); });
+        job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+      }
+      auto images = Run(job);
+      job.done(std::move(images));
+    }
+  }
+
+  static std::string CacheKey(const Job& job) {
+    std::stringstream key;
+    key << job.uri;
+    gchar* path = g_filename_from_uri(job.uri.c_str(), nullptr, nullptr);
+    if (path != nullptr) {
+      struct stat st {};
+      if (stat(path, &st) == 0) {
+        key << ':' << st.st_size << ':' << st.st_mtime;
+      }
+      g_free(path);
+    }
+    key << ':' << job.width << 'x' << job.height << ':' << job.mime;
+    return key.str();
+  }
+
+  static bool ReadFile(const std::string& path, std::vector<uint8_t>* data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+      return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = size > 0;
+    if (ok) {
+      data->resize(static_cast<size_t>(size));
+      ok = fread(data->data(), 1, data->size(), f) == data->size();
+    }
+    fclose(f);
+    return ok;
+  }
+
+  static void WriteFile(const std::string& path,
+                        const std::vector<uint8_t>& data) {
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (f == nullptr) {
+      return;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+      remove(tmp.c_str());
+    }
+  }
+
+  static std::vector<Image> Run(const Job& job) {
+    std::vector<Image> images;
+    std::string key = CacheKey(job);
+    const char* ext = job.mime == "image/png" ? ".png" : ".jpg";
+
+    GstElement* playbin = nullptr;
+    GstElement* sink = nullptr;
+    for (auto position_ms : job.positions_ms) {
+      std::stringstream name;
+      name << std::hex << std::hash<std::string>{}(key) << '-' << std::dec
+           << position_ms << ext;
+      Image image{position_ms, {},
+                  fml::paths::JoinPaths({job.cache_dir, name.str()})};
+      if (ReadFile(image.path, &image.data)) {
+        images.push_back(std::move(image));
+        continue;
+      }
+      if (playbin == nullptr && !Open(job.uri, &playbin, &sink)) {
+        break;
+      }
+      if (Extract(job, playbin, sink, position_ms, &image.data)) {
+        WriteFile(image.path, image.data);
+        images.push_back(std::move(image));
+      }
+    }
+    if (playbin) {
+      gst_element_set_state(playbin, GST_STATE_NULL);
+      gst_object_unref(sink);
+      gst_object_unref(playbin);
+    }
+    return images;
+  }
+
+  // Video only playbin into an appsink; audio is never decoded.  Only
+  // software decoders are plugged, the hardware instances are left to the
+  // players.
+  static bool Open(const std::string& uri,
+                   GstElement** playbin,
+                   GstElement** sink) {
+    decoder::Selector::GetInstance().Initialize();
+    *playbin = gst_element_factory_make("playbin", nullptr);
+    *sink = gst_element_factory_make("appsink", nullptr);
+    if (*playbin == nullptr || *sink == nullptr) {
+      FML_LOG(ERROR) << "Failed to create the thumbnail pipeline";
+      if (*playbin) {
+        gst_object_unref(*playbin);
+      }
+      if (*sink) {
+        gst_object_unref(*sink);
+      }
+      *playbin = *sink = nullptr;
+      return false;
+    }
+    GstCaps* caps = gst_caps_from_string("video/x-raw");
+    g_object_set(*sink, "sync", FALSE, "caps", caps, "max-buffers", 1u,
+                 "enable-last-sample", FALSE, nullptr);
+    gst_caps_unref(caps);
+    gst_object_ref(*sink);
+    g_object_set(*playbin, "uri", uri.c_str(), "video-sink", *sink, "flags",
+                 kPlayFlagVideo, nullptr);
+    g_signal_connect(*playbin, "element-setup",
+                     G_CALLBACK(decoder::Selector::OnSoftwareElementSetup),
+                     nullptr);
+    gst_element_set_state(*playbin, GST_STATE_PAUSED);
+    if (gst_element_get_state(*playbin, nullptr, nullptr, kFrameTimeout) !=
+        GST_STATE_CHANGE_SUCCESS) {
+      FML_LOG(ERROR) << "Cannot preroll " << uri << " for thumbnails";
+      gst_element_set_state(*playbin, GST_STATE_NULL);
+      gst_object_unref(*sink);
+      gst_object_unref(*playbin);
+      *playbin = *sink = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  static bool Extract(const Job& job,
+                      GstElement* playbin,
+                      GstElement* sink,
+                      int64_t position_ms,
+                      std::vector<uint8_t>* data) {
+    // previews do not need the exact frame, a key frame decodes fastest
+    if (!gst_element_seek_simple(
+            playbin, GST_FORMAT_TIME,
+            (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+                           GST_SEEK_FLAG_SNAP_NEAREST),
+            position_ms * GST_MSECOND) ||
+        gst_element_get_state(playbin, nullptr, nullptr, kFrameTimeout) !=
+            GST_STATE_CHANGE_SUCCESS) {
+      return false;
+    }
+    GstSample* sample =
+        gst_app_sink_try_pull_preroll(GST_APP_SINK(sink), kFrameTimeout);
+    if (sample == nullptr) {
+      return false;
+    }
+
+    // fit the frame into the requested box
+    GstVideoInfo info;
+    GstCaps* caps = gst_sample_get_caps(sample);
+    if (caps == nullptr || !gst_video_info_from_caps(&info, caps)) {
+      gst_sample_unref(sample);
+      return false;
+    }
+    gint width = job.width > 0 ? job.width : info.width;
+    gint height = job.height > 0 ? job.height : info.height;
+    if (static_cast<int64_t>(info.width) * height >
+        static_cast<int64_t>(info.height) * width) {
+      height = std::max<gint>(1, width * info.height / info.width);
+    } else {
+      width = std::max<gint>(1, height * info.width / info.height);
+    }
+    GstCaps* image_caps =
+        gst_caps_new_simple(job.mime.c_str(), "width", G_TYPE_INT, width,
+                            "height", G_TYPE_INT, height, nullptr);
+    GError* error = nullptr;
+    GstSample* image =
+        gst_video_convert_sample(sample, image_caps, kFrameTimeout, &error);
+    gst_caps_unref(image_caps);
+    gst_sample_unref(sample);
+    if (image == nullptr) {
+      FML_LOG(ERROR) << "Thumbnail conversion failed: "
+                     << (error ? error->message : "unknown error");
+      g_clear_error(&error);
+      return false;
+    }
+
+    GstBuffer* buffer = gst_sample_get_buffer(image);
+    GstMapInfo map;
+    bool ok = buffer && gst_buffer_map(buffer, &map, GST_MAP_READ);
+    if (ok) {
+      data->assign(map.data, map.data + map.size);
+      gst_buffer_unmap(buffer, &map);
+    }
+    gst_sample_unref(image);
+    return ok;
+  }
+};
+
+}  // namespace thumbnail
@@ -0,0 +1,445 @@
+#include <GLES3/gl3.h>
+#include <flutter/fml/logging.h>
+#include <gst/video/video.h>
+
+#include <sstream>
+#include <string>
+
+namespace yuv {
+
+// Frame formats rendered straight from the decoder.  Each one gets its own
+// fragment shader that samples the planes, converts to RGB and scales to
+// the output size in a single pass.
+enum Format { kNV12, kI420, kYUY2, kP010, kFormatCount };
+
+// appsink caps; a decoder producing anything else negotiates through
+// videoconvert, which is passthrough for these.
+#if GST_CHECK_VERSION(1, 10, 0)
+constexpr char kSinkCaps[] =
+    "video/x-raw, format=(string){ NV12, I420, YUY2, P010_10LE }";
+#else
+constexpr char kSinkCaps[] = "video/x-raw, format=(string){ NV12, I420, YUY2 }";
+#endif
+
+// appsink caps for an output size, 0x0 renders at the frame size.  The
+// shaders sample each plane once per output pixel, so frames are limited to
+// twice the output size for the linear filtered planar formats and to the
+// output size for the nearest sampled ones; videoscale downscales larger
+// frames before upload instead of the shader aliasing them.
+static GstCaps* SinkCaps(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    return gst_caps_from_string(kSinkCaps);
+  }
+  std::stringstream ss;
+  ss << "video/x-raw, format=(string){ NV12, I420 }, width=(int)[ 1, "
+     << 2 * width << " ], height=(int)[ 1, " << 2 * height << " ]; "
+#if GST_CHECK_VERSION(1, 10, 0)
+     << "video/x-raw, format=(string){ YUY2, P010_10LE }, "
+#else
+     << "video/x-raw, format=(string){ YUY2 }, "
+#endif
+     << "width=(int)[ 1, " << width << " ], height=(int)[ 1, " << height
+     << " ]";
+  return gst_caps_from_string(ss.str().c_str());
+}
+
+static bool FromVideoFormat(GstVideoFormat video_format, Format* format) {
+  switch (video_format) {
+    case GST_VIDEO_FORMAT_NV12:
+      *format = kNV12;
+      return true;
+    case GST_VIDEO_FORMAT_I420:
+      *format = kI420;
+      return true;
+    case GST_VIDEO_FORMAT_YUY2:
+      *format = kYUY2;
+      return true;
+#if GST_CHECK_VERSION(1, 10, 0)
+    case GST_VIDEO_FORMAT_P010_10LE:
+      *format = kP010;
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+// Quad drawn into the output texture, two triangles with their texture
+// coordinates.  The viewport is twice the output size, see
+// setup_render_state() in gstreamer.cc.
+static const GLfloat kQuadVertices[] = {
+    -0.5f, 0.5f,  0.0f, 0.5f,  0.5f,  0.0f, 0.5f,  -0.5f, 0.0f,
+
+    0.5f,  -0.5f, 0.0f, -0.5f, -0.5f, 0.0f, -0.5f, 0.5f,  0.0f,
+};
+
+static const GLfloat kQuadTexcoords[] = {
+    0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+
+    1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+};
+
+static const GLchar* vertexSource = R"glsl(
+  #version 320 es
+  precision highp float;
+
+  layout(location = 0) in vec3 vertexPosition_modelspace;
+  layout(location = 1) in vec2 texcoord;
+  out vec2 Texcoord;
+  void main()
+  {
+    Texcoord = texcoord;
+    gl_Position.xyz = vertexPosition_modelspace;
+    gl_Position.w = 1.0;
+  }
+)glsl";
+
+// Colour matrix and range are per stream, so they live in a uniform block
+// backed by a per player buffer; the program is shared by every player.
+static const GLchar* preamble = R"glsl(
+  #version 320 es
+  precision highp float;
+  precision highp int;
+  in vec2 Texcoord;
+  layout(std140, binding = 0) uniform ColorConversion {
+    mat4 colorMatrix;
+    ivec4 size;
+  };
+  layout(location = 0) out vec4 fragColor;
+  vec2 coord() {
+    return vec2(Texcoord.x, 1.0 - Texcoord.y);
+  }
+  ivec2 texel() {
+    return clamp(ivec2(coord() * vec2(size.xy)), ivec2(0), size.xy - 1);
+  }
+  vec4 toRGB(float y, float u, float v) {
+    return vec4(clamp((colorMatrix * vec4(y, u, v, 1.0)).rgb, 0.0, 1.0), 1.0);
+  }
+)glsl";
+
+static const GLchar* nv12Source = R"glsl(
+  layout(binding = 0) uniform sampler2D planeY;
+  layout(binding = 1) uniform sampler2D planeUV;
+  void main() {
+    vec2 uv = texture(planeUV, coord()).rg;
+    fragColor = toRGB(texture(planeY, coord()).r, uv.r, uv.g);
+  }
+)glsl";
+
+static const GLchar* i420Source = R"glsl(
+  layout(binding = 0) uniform sampler2D planeY;
+  layout(binding = 1) uniform sampler2D planeU;
+  layout(binding = 2) uniform sampler2D planeV;
+  void main() {
+    fragColor = toRGB(texture(planeY, coord()).r, texture(planeU, coord()).r,
+                      texture(planeV, coord()).r);
+  }
+)glsl";
+
+// Y0 U Y1 V macro pixels uploaded as RGBA, one texel per two pixels.
+static const GLchar* yuy2Source = R"glsl(
+  layout(binding = 0) uniform sampler2D planeYUYV;
+  void main() {
+    ivec2 p = texel();
+    vec4 yuyv = texelFetch(planeYUYV, ivec2(p.x / 2, p.y), 0);
+    fragColor = toRGB((p.x % 2 == 0) ? yuyv.r : yuyv.b, yuyv.g, yuyv.a);
+  }
+)glsl";
+
+// 10 bit samples in the high bits of 16 bit words.  Integer textures
+// cannot be filtered, so scaling is nearest.
+static const GLchar* p010Source = R"glsl(
+  layout(binding = 0) uniform highp usampler2D planeY;
+  layout(binding = 1) uniform highp usampler2D planeUV;
+  void main() {
+    ivec2 p = texel();
+    float y = float(texelFetch(planeY, p, 0).r) / 65535.0;
+    vec2 uv = vec2(texelFetch(planeUV, p / 2, 0).rg) / 65535.0;
+    fragColor = toRGB(y, uv.r, uv.g);
+  }
+)glsl";
+
+static std::string FragmentSource(Format format) {
+  const GLchar* sources[kFormatCount] = {nv12Source, i420Source, yuy2Source,
+                                         p010Source};
+  return std::string(preamble) + sources[format];
+}
+
+static GLuint LoadShaders(const GLchar* vsource, const GLchar* fsource) {
+  GLuint shaderProgram;
+  GLint result;
+  GLsizei length;
+  GLchar info[1000]{};
+
+  GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vertexShader, 1, &vsource, nullptr);
+  glCompileShader(vertexShader);
+  glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &result);
+  if (result == GL_FALSE) {
+    glGetShaderInfoLog(vertexShader, sizeof(info), &length, info);
+    FML_DLOG(ERROR) << "Failed to compile " << info;
+    return 0;
+  }
+
+  GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fragmentShader, 1, &fsource, nullptr);
+  glCompileShader(fragmentShader);
+  glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &result);
+  if (result == GL_FALSE) {
+    glGetShaderInfoLog(fragmentShader, sizeof(info), &length, info);
+    FML_DLOG(ERROR) << "Fail to compile " << info;
+    return 0;
+  }
+
+  shaderProgram = glCreateProgram();
+  glAttachShader(shaderProgram, vertexShader);
+  glAttachShader(shaderProgram, fragmentShader);
+  glLinkProgram(shaderProgram);
+
+  glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
+  if (result == GL_FALSE) {
+    glGetProgramInfoLog(shaderProgram, sizeof(info), &length, info);
+    FML_DLOG(ERROR) << "Fail to link " << info;
+    return 0;
+  }
+
+  glDetachShader(shaderProgram, vertexShader);
+  glDetachShader(shaderProgram, fragmentShader);
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+  return shaderProgram;
+}
+
+static GLuint CreateProgram(Format format) {
+  return LoadShaders(vertexSource, FragmentSource(format).c_str());
+}
+
+// Maps normalized Y'CbCr code values to RGB, including range expansion.
+// Column major, the fourth column holds the offsets.
+static void ColorMatrix(Format format,
+                        const GstVideoInfo* info,
+                        GLfloat matrix[16]) {
+  double kr, kb;
+  GstVideoColorMatrix color_matrix = info->colorimetry.matrix;
+  if (color_matrix == GST_VIDEO_COLOR_MATRIX_UNKNOWN ||
+      color_matrix == GST_VIDEO_COLOR_MATRIX_RGB) {
+    // untagged streams: HD is BT.709, SD is BT.601
+    color_matrix = info->height >= 720 ? GST_VIDEO_COLOR_MATRIX_BT709
+                                       : GST_VIDEO_COLOR_MATRIX_BT601;
+  }
+  switch (color_matrix) {
+    case GST_VIDEO_COLOR_MATRIX_BT709:
+      kr = 0.2126, kb = 0.0722;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_BT2020:
+      kr = 0.2627, kb = 0.0593;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_SMPTE240M:
+      kr = 0.212, kb = 0.087;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_FCC:
+      kr = 0.30, kb = 0.11;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_BT601:
+    default:
+      kr = 0.299, kb = 0.114;
+      break;
+  }
+  double kg = 1.0 - kr - kb;
+
+  // one 8 bit code value in normalized units
+  double unit = format == kP010 ? 256.0 / 65535.0 : 1.0 / 255.0;
+  bool full = info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+  double black = full ? 0.0 : 16.0 * unit;
+  double mid = 128.0 * unit;
+  double ys = 1.0 / ((full ? 255.0 : 219.0) * unit);
+  double cs = 1.0 / ((full ? 255.0 : 224.0) * unit);
+
+  double a[3][3] = {
+      {ys, 0.0, 2.0 * (1.0 - kr) * cs},
+      {ys, -2.0 * kb * (1.0 - kb) / kg * cs, -2.0 * kr * (1.0 - kr) / kg * cs},
+      {ys, 2.0 * (1.0 - kb) * cs, 0.0},
+  };
+  for (int row = 0; row < 3; row++) {
+    for (int col = 0; col < 3; col++) {
+      matrix[col * 4 + row] = static_cast<GLfloat>(a[row][col]);
+    }
+    matrix[12 + row] = static_cast<GLfloat>(
+        -(a[row][0] * black + a[row][1] * mid + a[row][2] * mid));
+    matrix[row * 4 + 3] = 0.0f;
+  }
+  matrix[15] = 1.0f;
+}
+
+// Points the player's framebuffer at its output texture.  Framebuffers
+// are per context, so this runs with the player context current.
+static void AttachFramebuffer(GLuint framebuffer, GLuint textureId) {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         textureId, 0);
+  GLenum DrawBuffers[] = {GL_COLOR_ATTACHMENT0};
+  glDrawBuffers(1, DrawBuffers);
+
+  switch (glCheckFramebufferStatus(GL_FRAMEBUFFER)) {
+    case GL_FRAMEBUFFER_COMPLETE:
+      break;
+    case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
+      FML_LOG(ERROR) << "failed to draw to framebuffer: "
+                        "the framebuffer attachment points are framebuffer "
+                        "incomplete";
+      break;
+    case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
+      FML_LOG(ERROR) << "failed to draw to framebuffer: "
+                        "the framebuffer does not have at least one image "
+                        "attached to it";
+      break;
+    case GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS:
+      FML_LOG(ERROR) << "failed to draw to framebuffer: "
+                        "GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS";
+      break;
+    case GL_FRAMEBUFFER_UNSUPPORTED:
+    default:
+      FML_LOG(ERROR) << "failed to draw to framebuffer: target is the default "
+                        "framebuffer, but the default framebuffer does not "
+                        "exist";
+      break;
+  }
+}
+
+// One plane texture and how frames are uploaded into it.
+struct Plane {
+  GLenum internal_format;
+  GLenum format;
+  GLenum type;
+  GLsizei width, height;
+  GLint bytes_per_texel;
+  GLint filter;
+};
+
+// Plane textures and conversion constants for one negotiated stream
+// format.  Textures and the uniform buffer are shared objects, so the
+// shader may be deleted from any context of the engine share group.
+class Shader {
+ public:
+  Format format;
+  GLuint program;
+  GLsizei width, height;
+  GstVideoColorimetry colorimetry;
+  size_t n_planes{};
+  Plane planes[3]{};
+  GLuint textures[3]{};
+  GLuint uniforms{};
+
+  Shader(GLuint _program, Format _format, const GstVideoInfo* info)
+      : format(_format),
+        program(_program),
+        width(info->width),
+        height(info->height),
+        colorimetry(info->colorimetry) {
+    GLsizei chroma_width = (width + 1) / 2;
+    GLsizei chroma_height = (height + 1) / 2;
+    switch (format) {
+      case kNV12:
+        addPlane({GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height, 1,
+                  GL_LINEAR});
+        addPlane({GL_RG8, GL_RG, GL_UNSIGNED_BYTE, chroma_width,
+                  chroma_height, 2, GL_LINEAR});
+        break;
+      case kI420:
+        addPlane({GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height, 1,
+                  GL_LINEAR});
+        addPlane({GL_R8, GL_RED, GL_UNSIGNED_BYTE, chroma_width,
+                  chroma_height, 1, GL_LINEAR});
+        addPlane({GL_R8, GL_RED, GL_UNSIGNED_BYTE, chroma_width,
+                  chroma_height, 1, GL_LINEAR});
+        break;
+      case kYUY2:
+        addPlane({GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, chroma_width, height,
+                  4, GL_NEAREST});
+        break;
+      case kP010:
+        addPlane({GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, width, height,
+                  2, GL_NEAREST});
+        addPlane({GL_RG16UI, GL_RG_INTEGER, GL_UNSIGNED_SHORT, chroma_width,
+                  chroma_height, 4, GL_NEAREST});
+        break;
+      default:
+        break;
+    }
+
+    // Plane storage is allocated once at the negotiated size; frames only
+    // update it with glTexSubImage2D.
+    glGenTextures(static_cast<GLsizei>(n_planes), textures);
+    for (size_t i = 0; i < n_planes; i++) {
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glTexStorage2D(GL_TEXTURE_2D, 1, planes[i].internal_format,
+                     planes[i].width, planes[i].height);
+      setPlaneParameters(planes[i].filter);
+    }
+
+    struct {
+      GLfloat matrix[16];
+      GLint size[4];
+    } block{};
+    ColorMatrix(format, info, block.matrix);
+    block.size[0] = width;
+    block.size[1] = height;
+    glGenBuffers(1, &uniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniforms);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  ~Shader() {
+    glDeleteTextures(static_cast<GLsizei>(n_planes), textures);
+    glDeleteBuffers(1, &uniforms);
+  }
+
+  Shader(const Shader&) = delete;
+  const Shader& operator=(const Shader&) = delete;
+
+  [[nodiscard]] bool Matches(Format _format, const GstVideoInfo* info) const {
+    return format == _format && width == info->width &&
+           height == info->height &&
+           colorimetry.matrix == info->colorimetry.matrix &&
+           colorimetry.range == info->colorimetry.range;
+  }
+
+  // Binds program, planes and conversion constants in the current context.
+  void Bind() const {
+    glUseProgram(program);
+    for (size_t i = 0; i < n_planes; i++) {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uniforms);
+  }
+
+  // Uploads every plane of a mapped frame.  Strides are in bytes.
+  void LoadFrame(const GstVideoFrame* frame) const {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < n_planes; i++) {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH,
+                    GST_VIDEO_FRAME_PLANE_STRIDE(frame, i) /
+                        planes[i].bytes_per_texel);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planes[i].width,
+                      planes[i].height, planes[i].format, planes[i].type,
+                      GST_VIDEO_FRAME_PLANE_DATA(frame, i));
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  }
+
+ private:
+  void addPlane(const Plane& plane) { planes[n_planes++] = plane; }
+
+  static void setPlaneParameters(GLint filter) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+  }
+};
+
+};  // namespace yuv
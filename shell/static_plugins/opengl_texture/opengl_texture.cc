@@ -76,6 +76,29 @@ void OpenGlTexture::OnPlatformMessage(const FlutterPlatformMessage* message,
     } else {
       result = codec.EncodeErrorEnvelope("argument_error", "Invalid Arguments");
     }
+  } else if (method == "memoryStats") {
+    auto stats = engine->GetTextureMemoryStats();
+
+    flutter::EncodableMap textures;
+    for (auto const& item : stats.textures) {
+      textures[flutter::EncodableValue(item.first)] =
+          flutter::EncodableValue(static_cast<int64_t>(item.second));
+    }
+
+    flutter::EncodableValue value(flutter::EncodableMap{
+        {flutter::EncodableValue("total"),
+         flutter::EncodableValue(static_cast<int64_t>(stats.total_bytes))},
+        {flutter::EncodableValue("peak"),
+         flutter::EncodableValue(static_cast<int64_t>(stats.peak_bytes))},
+        {flutter::EncodableValue("budget"),
+         flutter::EncodableValue(static_cast<int64_t>(stats.budget_bytes))},
+        {flutter::EncodableValue("budgetExceeded"),
+         flutter::EncodableValue(
+             static_cast<int64_t>(stats.budget_exceeded_count))},
+        {flutter::EncodableValue("textures"),
+         flutter::EncodableValue(textures)},
+    });
+    result = codec.EncodeSuccessEnvelope(&value);
   }
   engine->SendPlatformMessageResponse(message->response_handle, result->data(),
                                       result->size());
@@ -0,0 +1,189 @@
+// Copyright 2020 Toyota Connected North America
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "texture_pixel_buffer.h"
+
+#include <algorithm>
+
+#include <flutter/fml/logging.h>
+
+#include "egl_window.h"
+#include "engine.h"
+
+// Above this count dirty regions collapse to their bounding box
+constexpr size_t kMaxDirtyRects = 16;
+
+PixelBufferTexture::PixelBufferTexture(int64_t id,
+                                       int32_t width,
+                                       int32_t height)
+    : Texture(id, GL_TEXTURE_2D, GL_RGBA8, Create, Dispose, width, height),
+      m_buffer(static_cast<size_t>(width) * height * 4, 0),
+      m_texture_id(0) {}
+
+PixelBufferTexture::~PixelBufferTexture() = default;
+
+void PixelBufferTexture::Create(void* userdata) {
+  auto* obj = (PixelBufferTexture*)userdata;
+
+  if (!obj->m_flutter_engine) {
+    FML_LOG(ERROR) << "PixelBufferTexture: engine not set";
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(obj->m_buffer_mutex);
+  obj->m_buffer.assign(static_cast<size_t>(obj->m_width) * obj->m_height * 4,
+                       0);
+  obj->m_dirty.clear();
+
+  auto egl_window = obj->m_flutter_engine->GetEglWindow();
+  egl_window->MakeTextureCurrent();
+
+  glGenTextures(1, &obj->m_texture_id);
+  glBindTexture(GL_TEXTURE_2D, obj->m_texture_id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, obj->m_width, obj->m_height);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, obj->m_width, obj->m_height,
+                  GL_RGBA, GL_UNSIGNED_BYTE, obj->m_buffer.data());
+
+  glFinish();
+  egl_window->ClearCurrent();
+
+  obj->TrackAllocation(GL_RGBA8, obj->m_width, obj->m_height);
+  obj->Enable(obj->m_texture_id);
+}
+
+void PixelBufferTexture::Dispose(void* userdata) {
+  auto* obj = (PixelBufferTexture*)userdata;
+
+  std::lock_guard<std::mutex> lock(obj->m_buffer_mutex);
+  if (obj->m_texture_id) {
+    obj->Disable();
+    auto egl_window = obj->m_flutter_engine->GetEglWindow();
+    egl_window->MakeTextureCurrent();
+    glDeleteTextures(1, &obj->m_texture_id);
+    egl_window->ClearCurrent();
+    obj->m_texture_id = 0;
+  }
+}
+
+uint8_t* PixelBufferTexture::Lock() {
+  m_buffer_mutex.lock();
+  return m_buffer.data();
+}
+
+void PixelBufferTexture::MarkDirty(int32_t x,
+                                   int32_t y,
+                                   int32_t width,
+                                   int32_t height) {
+  // clip to the surface
+  int32_t x0 = std::max(x, 0);
+  int32_t y0 = std::max(y, 0);
+  int32_t x1 = std::min(x + width, m_width);
+  int32_t y1 = std::min(y + height, m_height);
+  if (x1 <= x0 || y1 <= y0) {
+    return;
+  }
+  m_dirty.push_back({x0, y0, x1 - x0, y1 - y0});
+}
+
+void PixelBufferTexture::MarkAllDirty() {
+  m_dirty.clear();
+  m_dirty.push_back({0, 0, m_width, m_height});
+}
+
+void PixelBufferTexture::Unlock() {
+  if (!m_dirty.empty() && m_texture_id) {
+    Upload();
+  }
+  m_dirty.clear();
+  m_buffer_mutex.unlock();
+}
+
+void PixelBufferTexture::Upload() {
+  MergeRects(m_dirty);
+
+  auto egl_window = m_flutter_engine->GetEglWindow();
+  egl_window->MakeTextureCurrent();
+
+  glBindTexture(GL_TEXTURE_2D, m_texture_id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, m_width);
+  for (auto const& rect : m_dirty) {
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.y);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height,
+                    GL_RGBA, GL_UNSIGNED_BYTE, m_buffer.data());
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+  glFinish();
+  egl_window->ClearCurrent();
+
+  FrameReady();
+}
+
+void PixelBufferTexture::MergeRects(std::vector<Rect>& rects) {
+  auto area = [](const Rect& r) -> int64_t {
+    return static_cast<int64_t>(r.width) * r.height;
+  };
+
+  // Merge pairs that overlap or share an edge when the bounding box does not
+  // cover more than the two rects do on their own.
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < rects.size() && !merged; i++) {
+      for (size_t j = i + 1; j < rects.size(); j++) {
+        const Rect& a = rects[i];
+        const Rect& b = rects[j];
+        if (a.x > b.x + b.width || b.x > a.x + a.width ||
+            a.y > b.y + b.height || b.y > a.y + a.height) {
+          continue;
+        }
+        int32_t x0 = std::min(a.x, b.x);
+        int32_t y0 = std::min(a.y, b.y);
+        int32_t x1 = std::max(a.x + a.width, b.x + b.width);
+        int32_t y1 = std::max(a.y + a.height, b.y + b.height);
+        Rect u{x0, y0, x1 - x0, y1 - y0};
+        if (area(u) > area(a) + area(b)) {
+          continue;
+        }
+        rects[i] = u;
+        rects.erase(rects.begin() + static_cast<long>(j));
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  if (rects.size() > kMaxDirtyRects) {
+    Rect bounds = rects[0];
+    for (auto const& r : rects) {
+      int32_t x1 = std::max(bounds.x + bounds.width, r.x + r.width);
+      int32_t y1 = std::max(bounds.y + bounds.height, r.y + r.height);
+      bounds.x = std::min(bounds.x, r.x);
+      bounds.y = std::min(bounds.y, r.y);
+      bounds.width = x1 - bounds.x;
+      bounds.height = y1 - bounds.y;
+    }
+    rects.clear();
+    rects.push_back(bounds);
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <GLES3/gl3.h>
+
+#include <flutter_embedder.h>
+
+#include "flutter/fml/macros.h"
+#include "textures/texture.h"
+
+// RGBA texture backed by a CPU pixel buffer.
+//
+// Producers Lock() the buffer, write pixels, MarkDirty() the regions they
+// touched and Unlock().  Only the dirty regions are uploaded to the GL
+// texture on the texture context, after which the engine is notified.
+class PixelBufferTexture : public Texture {
+ public:
+  struct Rect {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+  };
+
+  PixelBufferTexture(int64_t id, int32_t width, int32_t height);
+  ~PixelBufferTexture() override;
+
+  // Returns the RGBA buffer, tightly packed, GetStride() bytes per row
+  uint8_t* Lock();
+  void MarkDirty(int32_t x, int32_t y, int32_t width, int32_t height);
+  void MarkAllDirty();
+  void Unlock();
+
+  [[nodiscard]] int32_t GetStride() const { return m_width * 4; }
+
+  static void MergeRects(std::vector<Rect>& rects);
+
+  FML_DISALLOW_COPY_AND_ASSIGN(PixelBufferTexture);
+
+ private:
+  std::mutex m_buffer_mutex;
+  std::vector<uint8_t> m_buffer;
+  std::vector<Rect> m_dirty;
+  GLuint m_texture_id;
+
+  void Upload();
+
+  static void Create(void* userdata);
+  static void Dispose(void* userdata);
+};
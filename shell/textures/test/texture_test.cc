@@ -17,44 +17,98 @@
 
 #include <chrono>
 
+#include <flutter/fml/logging.h>
+
 #include "app.h"
 #include "egl_window.h"
 #include "engine.h"
 #include "platform_channel.h"
 #include "textures/texture.h"
 
-constexpr int64_t kTestTextureObjectId = 5150;
+TextureTest::Config TextureTest::m_config;
+
+static int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
-TextureTest::TextureTest(App* app)
-    : Texture(kTestTextureObjectId, GL_TEXTURE_2D, GL_RGBA8, Create, Dispose),
+TextureTest::TextureTest(App* app, size_t index)
+    : Texture(kTestTextureObjectId + static_cast<int64_t>(index),
+              GL_TEXTURE_2D,
+              m_config.alpha ? GL_RGBA8 : GL_RGB8,
+              Create,
+              Dispose,
+              m_config.width,
+              m_config.height),
       m_egl_window(app->GetEglWindow(0)),
-      m_initialized(false) {}
+      m_initialized(false),
+      m_index(index),
+      m_texture_id(0),
+      m_frame(0),
+      m_next_frame_time(0),
+      m_upload_time(0),
+      m_last_sample_time(0),
+      m_frame_pending(false),
+      m_dropped(0) {}
+
+TextureTest::~TextureTest() {
+  if (m_initialized) {
+    Report();
+  }
+}
 
-TextureTest::~TextureTest() = default;
+bool TextureTest::ParsePattern(const std::string& name, Pattern* pattern) {
+  if (name == "gradient") {
+    *pattern = PATTERN_GRADIENT;
+  } else if (name == "checker") {
+    *pattern = PATTERN_CHECKER;
+  } else if (name == "noise") {
+    *pattern = PATTERN_NOISE;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void TextureTest::Timing::Add(int64_t value) {
+  if (count == 0 || value < min)
+    min = value;
+  if (count == 0 || value > max)
+    max = value;
+  total += value;
+  count++;
+}
 
 void TextureTest::Create(void* userdata) {
   auto* obj = (TextureTest*)userdata;
 
-  obj->m_egl_window->MakeTextureCurrent();
+  // the size requested by the Dart side is ignored, the benchmark size wins
+  obj->m_width = m_config.width;
+  obj->m_height = m_config.height;
+  size_t bpp = m_config.alpha ? 4 : 3;
+  obj->m_pixels.resize(static_cast<size_t>(obj->m_width) * obj->m_height *
+                       bpp);
 
-  GLubyte pixels[4 * 3] = {
-      255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 255, 0,
-  };
+  obj->m_egl_window->MakeTextureCurrent();
 
-  GLuint textureId;
-  glGenTextures(1, &textureId);
-  glBindTexture(GL_TEXTURE_2D, textureId);
+  glGenTextures(1, &obj->m_texture_id);
+  glBindTexture(GL_TEXTURE_2D, obj->m_texture_id);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE,
-               pixels);
+  GLenum format = m_config.alpha ? GL_RGBA : GL_RGB;
+  glTexImage2D(GL_TEXTURE_2D, 0, format, obj->m_width, obj->m_height, 0,
+               format, GL_UNSIGNED_BYTE, nullptr);
 
   glFinish();
   obj->m_egl_window->ClearCurrent();
 
+  obj->Upload();
+
   obj->m_initialized = true;
-  obj->Enable(textureId);
+  obj->TrackAllocation(format, obj->m_width, obj->m_height);
+  obj->Enable(obj->m_texture_id);
 }
 
 void TextureTest::Dispose(void* userdata) {
@@ -62,13 +116,126 @@ void TextureTest::Dispose(void* userdata) {
   obj->Disable();
 }
 
+void TextureTest::FillPattern() {
+  size_t bpp = m_config.alpha ? 4 : 3;
+  uint32_t seed = (m_frame + 1) * 2654435761u + m_index;
+  for (int32_t y = 0; y < m_height; y++) {
+    GLubyte* row = &m_pixels[static_cast<size_t>(y) * m_width * bpp];
+    for (int32_t x = 0; x < m_width; x++) {
+      GLubyte* p = &row[x * bpp];
+      switch (m_config.pattern) {
+        case PATTERN_GRADIENT:
+          p[0] = static_cast<GLubyte>(x + m_frame);
+          p[1] = static_cast<GLubyte>(y + m_frame);
+          p[2] = static_cast<GLubyte>(m_frame);
+          break;
+        case PATTERN_CHECKER: {
+          GLubyte c = (((x + m_frame) >> 4) ^ (y >> 4)) & 1 ? 255 : 0;
+          p[0] = p[1] = p[2] = c;
+          break;
+        }
+        case PATTERN_NOISE:
+          seed ^= seed << 13;
+          seed ^= seed >> 17;
+          seed ^= seed << 5;
+          p[0] = static_cast<GLubyte>(seed);
+          p[1] = static_cast<GLubyte>(seed >> 8);
+          p[2] = static_cast<GLubyte>(seed >> 16);
+          break;
+      }
+      if (bpp == 4)
+        p[3] = 255;
+    }
+  }
+}
+
+void TextureTest::Upload() {
+  FillPattern();
+
+  int64_t start = NowNs();
+
+  m_egl_window->MakeTextureCurrent();
+  glBindTexture(GL_TEXTURE_2D, m_texture_id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height,
+                  m_config.alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE,
+                  m_pixels.data());
+  glFinish();
+  m_egl_window->ClearCurrent();
+
+  m_upload_time = NowNs();
+  m_upload_timing.Add(m_upload_time - start);
+
+  // previous frame was replaced before the engine sampled it
+  if (m_frame_pending)
+    m_dropped++;
+  m_frame_pending = true;
+  m_frame++;
+}
+
 void TextureTest::Draw(void* userdata) {
   auto* obj = (TextureTest*)userdata;
 
-  if (!m_draw_next)
+  if (!obj->m_initialized)
     return;
 
-  m_draw_next = false;
+  int64_t sample_time = obj->m_sample_time;
+  if (obj->m_frame_pending && sample_time != obj->m_last_sample_time &&
+      sample_time >= obj->m_upload_time) {
+    obj->m_latency_timing.Add(sample_time - obj->m_upload_time);
+    obj->m_frame_pending = false;
+  }
+  obj->m_last_sample_time = sample_time;
+
+  if (m_config.fps == 0) {
+    // upload once, redraw on sample
+    if (!m_draw_next)
+      return;
 
+    m_draw_next = false;
+
+    obj->FrameReady();
+    return;
+  }
+
+  int64_t now = NowNs();
+  if (now < obj->m_next_frame_time)
+    return;
+
+  int64_t period = 1000000000LL / m_config.fps;
+  obj->m_next_frame_time =
+      (obj->m_next_frame_time == 0 || now - obj->m_next_frame_time > period)
+          ? now + period
+          : obj->m_next_frame_time + period;
+
+  obj->Upload();
   obj->FrameReady();
 }
+
+int64_t TextureTest::GetNextFrameTime() const {
+  if (!m_initialized || m_config.fps == 0) {
+    return 0;
+  }
+  // the first upload happens on the next Draw()
+  return m_next_frame_time ? m_next_frame_time : NowNs();
+}
+
+void TextureTest::Report() const {
+  auto avg_us = [](const Timing& t) -> double {
+    return t.count ? static_cast<double>(t.total) / t.count / 1000.0 : 0.0;
+  };
+
+  FML_LOG(INFO) << "TextureTest (" << m_id << ") " << m_width << "x"
+                << m_height << (m_config.alpha ? " RGBA" : " RGB") << " @ "
+                << m_config.fps << " fps";
+  FML_LOG(INFO) << "\tframes uploaded: " << m_upload_timing.count;
+  FML_LOG(INFO) << "\tupload us: min " << m_upload_timing.min / 1000
+                << ", avg " << avg_us(m_upload_timing) << ", max "
+                << m_upload_timing.max / 1000;
+  FML_LOG(INFO) << "\tframes sampled: " << m_latency_timing.count;
+  FML_LOG(INFO) << "\tframe available to sample us: min "
+                << m_latency_timing.min / 1000 << ", avg "
+                << avg_us(m_latency_timing) << ", max "
+                << m_latency_timing.max / 1000;
+  FML_LOG(INFO) << "\tdropped updates: " << m_dropped;
+}
@@ -18,11 +18,15 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <GLES2/gl2.h>
 #ifndef GL_RGBA8
 #define GL_RGBA8 0x8058
 #endif
+#ifndef GL_RGB8
+#define GL_RGB8 0x8051
+#endif
 
 #include <flutter_embedder.h>
 
@@ -33,20 +37,74 @@ class App;
 class EglWindow;
 class Engine;
 
+constexpr int64_t kTestTextureObjectId = 5150;
+
+// Benchmark texture source.
+//
+// Each instance owns one texture (object id kTestTextureObjectId + index)
+// that is re-uploaded with a synthetic pattern at the configured frame rate.
+// Upload time, upload to engine sample latency and updates that were
+// replaced before the engine sampled them are reported at exit.
 class TextureTest : public Texture {
  public:
-  explicit TextureTest(App* app);
-  ~TextureTest();
+  enum Pattern { PATTERN_GRADIENT, PATTERN_CHECKER, PATTERN_NOISE };
+
+  struct Config {
+    size_t count = 1;
+    int32_t width = 2;
+    int32_t height = 2;
+    bool alpha = false;
+    uint32_t fps = 0;  // 0 uploads once
+    Pattern pattern = PATTERN_GRADIENT;
+  };
+
+  // set from the command line before App creates the test textures
+  static void SetConfig(const Config& config) { m_config = config; }
+  static const Config& GetConfig() { return m_config; }
+  static bool ParsePattern(const std::string& name, Pattern* pattern);
+
+  explicit TextureTest(App* app, size_t index = 0);
+  ~TextureTest() override;
 
   void Draw(void* userdata);
 
+  // steady clock time (ns) of the next timed upload, 0 if none is due
+  [[nodiscard]] int64_t GetNextFrameTime() const;
+
   FML_DISALLOW_COPY_AND_ASSIGN(TextureTest);
 
  private:
+  static Config m_config;
+
   [[maybe_unused]] bool m_initialized;
 
   std::shared_ptr<EglWindow> m_egl_window;
 
+  size_t m_index;
+  GLuint m_texture_id;
+  std::vector<GLubyte> m_pixels;
+  uint32_t m_frame;
+
+  int64_t m_next_frame_time;
+  int64_t m_upload_time;
+  int64_t m_last_sample_time;
+  bool m_frame_pending;
+
+  struct Timing {
+    uint64_t count = 0;
+    int64_t min = 0;
+    int64_t max = 0;
+    int64_t total = 0;
+    void Add(int64_t value);
+  };
+  Timing m_upload_timing;
+  Timing m_latency_timing;
+  uint64_t m_dropped;
+
+  void FillPattern();
+  void Upload();
+  void Report() const;
+
   static void Create(void* userdata);
   static void Dispose(void* userdata);
 };
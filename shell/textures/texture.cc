@@ -14,7 +14,11 @@
 
 #include "texture.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+
+#include <GLES3/gl3.h>
 
 #include <flutter/fml/logging.h>
 
@@ -31,17 +35,25 @@ Texture::Texture(uint32_t id,
     : m_flutter_engine(nullptr),
       m_create_callback(create_callback),
       m_dispose_callback(dispose_callback),
+      m_memory_pressure_callback(nullptr),
+      m_memory_usage(0),
       m_enabled(false),
       m_draw_next(false),
+      m_sample_time(0),
       m_target(target),
       m_id(id),
       m_name(0),
+      m_flutter_id(0),
       m_format(format),
       m_height(height),
       m_width(width) {}
 
 Texture::~Texture() {
   FML_DLOG(INFO) << "Texture Destructor";
+  if (m_flutter_engine) {
+    ReleaseAllocations();
+    m_flutter_engine->TextureRegistryRemove(this);
+  }
 }
 
 void Texture::GetFlutterOpenGLTexture(FlutterOpenGLTexture* texture_out,
@@ -54,6 +66,9 @@ void Texture::GetFlutterOpenGLTexture(FlutterOpenGLTexture* texture_out,
   texture_out->format = m_format;
 
   m_draw_next = true;
+  m_sample_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
 }
 
 int64_t Texture::Create(int32_t width, int32_t height) {
@@ -69,10 +84,12 @@ void Texture::Dispose() {
   if (m_dispose_callback) {
     m_dispose_callback(this);
   }
+  ReleaseAllocations();
 }
 
 void Texture::Enable(GLuint name) {
   m_name = name;
+  m_flutter_id = name;
 
   if (m_flutter_engine) {
     // Add again for assigned EGL texture id
@@ -93,10 +110,21 @@ void Texture::Enable(GLuint name) {
   }
 }
 
+void Texture::EnableDeferred() {
+  if (m_flutter_engine) {
+    // registered under m_id by SetEngine()
+    m_flutter_id = m_id;
+    if (kSuccess != m_flutter_engine->TextureEnable(m_flutter_id)) {
+      assert(false);
+    }
+    m_enabled = true;
+  }
+}
+
 void Texture::Disable() {
   if (m_flutter_engine)
-    assert(m_name);
-  m_flutter_engine->TextureDisable(m_name);
+    assert(m_flutter_id);
+  m_flutter_engine->TextureDisable(m_flutter_id);
   m_enabled = false;
 }
 
@@ -104,11 +132,104 @@ void Texture::SetEngine(const std::shared_ptr<Engine>& engine) {
   if (engine) {
     m_flutter_engine = engine;
     engine->TextureRegistryAdd(m_id, this);
+    // account for allocations made before an engine was assigned
+    if (m_memory_usage) {
+      engine->TextureMemoryAdd(m_memory_usage);
+    }
   }
 }
 
 void Texture::FrameReady() {
+  // notified once per frame by the platform loop
   if (m_flutter_engine)
-    m_flutter_engine->MarkExternalTextureFrameAvailable(m_flutter_engine,
-                                                        m_name);
+    m_flutter_engine->QueueTextureFrameAvailable(m_flutter_id);
+}
+
+int Texture::GetMipLevels(int width, int height) {
+  int levels = 1;
+  int size = std::max(width, height);
+  while (size > 1) {
+    size >>= 1;
+    levels++;
+  }
+  return levels;
+}
+
+size_t Texture::GetBytesPerPixel(uint32_t format) {
+  switch (format) {
+    case GL_R8:
+    case GL_RED:
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+      return 1;
+    case GL_RG8:
+    case GL_RG:
+    case GL_LUMINANCE_ALPHA:
+    case GL_RGB565:
+    case GL_RGBA4:
+    case GL_RGB5_A1:
+    case GL_R16F:
+    case GL_R16UI:
+    case GL_DEPTH_COMPONENT16:
+      return 2;
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_DEPTH_COMPONENT24:
+      return 3;
+    case GL_RGBA:
+    case GL_RGBA8:
+    case GL_RG16F:
+    case GL_RG16UI:
+    case GL_RGB10_A2:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT32F:
+      return 4;
+    case GL_RGBA16F:
+      return 8;
+    default:
+      FML_DLOG(ERROR) << "Unknown texture format: 0x" << std::hex << format
+                      << ", assuming 4 bytes per pixel";
+      return 4;
+  }
+}
+
+size_t Texture::CalculateMemorySize(uint32_t format,
+                                    int width,
+                                    int height,
+                                    int mip_levels) {
+  if (width <= 0 || height <= 0) {
+    return 0;
+  }
+  size_t bpp = GetBytesPerPixel(format);
+  size_t size = 0;
+  for (int level = 0; level < mip_levels; level++) {
+    size += static_cast<size_t>(std::max(width >> level, 1)) *
+            static_cast<size_t>(std::max(height >> level, 1)) * bpp;
+  }
+  return size;
+}
+
+size_t Texture::TrackAllocation(uint32_t format,
+                                int width,
+                                int height,
+                                int mip_levels) {
+  size_t size = CalculateMemorySize(format, width, height, mip_levels);
+  m_memory_usage += size;
+  if (m_flutter_engine) {
+    m_flutter_engine->TextureMemoryAdd(size);
+  }
+  return size;
+}
+
+void Texture::ReleaseAllocations() {
+  size_t size = m_memory_usage.exchange(0);
+  if (size && m_flutter_engine) {
+    m_flutter_engine->TextureMemoryRemove(size);
+  }
+}
+
+void Texture::OnMemoryPressure(size_t over_budget) {
+  if (m_memory_pressure_callback) {
+    m_memory_pressure_callback(this, over_budget);
+  }
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -37,7 +38,7 @@ class Texture {
           int width = 0,
           int height = 0);
 
-  ~Texture();
+  virtual ~Texture();
 
   Texture(const Texture&) = delete;
 
@@ -52,15 +53,53 @@ class Texture {
   int64_t Create(int width, int height);
   void Dispose();
   void Enable(uint32_t name);
+  // Registers the texture with Flutter under its id before a GL texture
+  // exists.  The producer attaches one with SetName(); until then the
+  // texture is not sampled.
+  void EnableDeferred();
+  void SetName(uint32_t name) { m_name = name; }
   void Disable();
   void FrameReady();
   [[maybe_unused]] [[nodiscard]] int64_t GetTextureId() const { return m_name; }
+  [[nodiscard]] int64_t GetId() const { return m_id; }
+
+  // Memory accounting
+  //
+  // Producers report each GL allocation backing this texture (output
+  // texture, plane textures, renderbuffers).  Totals are rolled up per
+  // engine and checked against the engine texture memory budget.
+  static int GetMipLevels(int width, int height);
+  static size_t GetBytesPerPixel(uint32_t format);
+  static size_t CalculateMemorySize(uint32_t format,
+                                    int width,
+                                    int height,
+                                    int mip_levels = 1);
+
+  size_t TrackAllocation(uint32_t format,
+                         int width,
+                         int height,
+                         int mip_levels = 1);
+  void ReleaseAllocations();
+  [[nodiscard]] size_t GetMemoryUsage() const { return m_memory_usage; }
+
+  // Called by the engine with the bytes over budget when an allocation
+  // pushes the texture memory total over budget, and with 0 once releases
+  // bring it back under.  Producers may downscale or release in proportion
+  // and undo it when called with 0.
+  typedef void (*MemoryPressureCallback)(Texture* texture, size_t over_budget);
+  void SetMemoryPressureCallback(MemoryPressureCallback callback) {
+    m_memory_pressure_callback = callback;
+  }
+  void OnMemoryPressure(size_t over_budget);
 
  protected:
   std::shared_ptr<Engine> m_flutter_engine;
   [[maybe_unused]] bool m_enabled;
   int64_t m_id;
-  int64_t m_name;
+  // GL texture name, set by the producer thread and read by the raster thread
+  std::atomic<int64_t> m_name;
+  // id the texture is registered with Flutter under, see EnableDeferred()
+  int64_t m_flutter_id;
   uint32_t m_target;
   uint32_t m_format;
   [[maybe_unused]] int m_width;
@@ -69,8 +108,13 @@ class Texture {
   [[maybe_unused]] EGLSurface m_surface{};
 
   bool m_draw_next;
+  // steady clock time (ns) the engine last sampled this texture
+  std::atomic<int64_t> m_sample_time;
 
  private:
   const VoidCallback m_create_callback;
   const VoidCallback m_dispose_callback;
+  MemoryPressureCallback m_memory_pressure_callback;
+
+  std::atomic<size_t> m_memory_usage;
 };
\ No newline at end of file